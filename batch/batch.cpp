@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <omp.h>
+#include "batch.h"
+
+CsvWriter::CsvWriter(const std::string &path, std::size_t flush_size)
+    : out(path, std::ios::app), flush_size(flush_size)
+{
+    buffer.reserve(flush_size);
+    // A row cut short by a crash gets its newline, so the next row starts on its own line
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (in && in.tellg() > 0)
+    {
+        in.seekg(-1, std::ios::end);
+        if (in.get() != '\n')
+            buffer += '\n';
+    }
+}
+
+CsvWriter::~CsvWriter()
+{
+    flush();
+}
+
+bool CsvWriter::is_open() const
+{
+    return out.is_open();
+}
+
+void CsvWriter::flush_locked()
+{
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    buffer.clear();
+}
+
+void CsvWriter::write_row(const std::string &row)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer += row;
+    buffer += '\n';
+    if (buffer.size() >= flush_size)
+        flush_locked();
+}
+
+void CsvWriter::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    flush_locked();
+}
+
+BatchRunner::BatchRunner(int threads)
+    : threads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+void BatchRunner::add_job(int instance, int configuration, int repetition, double cost)
+{
+    jobs.push_back(BatchJob{instance, configuration, repetition, cost});
+}
+
+int BatchRunner::get_threads() const
+{
+    return threads;
+}
+
+void BatchRunner::run(const std::function<void(const BatchJob &)> &job_function)
+{
+    // Stable, so jobs of equal cost keep the order they were added in
+    std::stable_sort(jobs.begin(), jobs.end(), [](const BatchJob &a, const BatchJob &b)
+                     { return a.cost > b.cost; });
+
+    std::atomic<std::size_t> next(0);
+    int count = std::min<std::size_t>(threads, jobs.size());
+    auto work = [&]()
+    {
+        // One job per core: OpenMP loops inside a job (the GA's) would oversubscribe the others
+        if (count > 1)
+            omp_set_num_threads(1);
+        for (std::size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1))
+            job_function(jobs[i]);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < count; ++t)
+        pool.emplace_back(work);
+    for (std::thread &thread : pool)
+        thread.join();
+    jobs.clear();
+}
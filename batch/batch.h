@@ -0,0 +1,66 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One unit of a batch: repetition `repetition` of configuration `configuration` on instance
+// `instance`. What the indices mean is up to the caller.
+struct BatchJob
+{
+    int instance;
+    int configuration;
+    int repetition;
+    double cost; // Expected running time in any unit (e.g. vertices + edges); larger runs first
+};
+
+// CSV output shared by worker threads. Every row is appended whole under a lock, so rows never
+// interleave. By default each row is flushed as soon as it is written, like the serial tests
+// do, so a crash or Ctrl-C loses at most the rows of the jobs still running; a flush_size
+// above zero buffers rows until that many bytes are waiting.
+class CsvWriter
+{
+private:
+    std::ofstream out;
+    std::mutex mutex; // Guards buffer and out
+    std::string buffer;
+    std::size_t flush_size;
+
+    void flush_locked();
+
+public:
+    // Appends to `path`, like the serial tests do
+    explicit CsvWriter(const std::string &path, std::size_t flush_size = 0);
+    ~CsvWriter();
+
+    bool is_open() const;
+    // `row` without the trailing newline
+    void write_row(const std::string &row);
+    void flush();
+};
+
+// Runs a list of jobs on a pool of worker threads. Jobs are sorted by decreasing cost and
+// handed out one at a time, so the long ones start first and the short ones fill the gaps
+// at the end (longest processing time first).
+class BatchRunner
+{
+private:
+    std::vector<BatchJob> jobs;
+    int threads;
+
+public:
+    // `threads` defaults to the hardware concurrency
+    explicit BatchRunner(int threads = 0);
+
+    void add_job(int instance, int configuration, int repetition, double cost);
+    int get_threads() const;
+
+    // Calls job_function once per job, from the worker threads; returns when all are done
+    void run(const std::function<void(const BatchJob &)> &job_function);
+};
+
+#endif // BATCH_H
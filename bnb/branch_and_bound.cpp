@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include "branch_and_bound.h"
+
+BranchAndBound::BranchAndBound(const Graph &graph, const std::vector<int> &initial_clique)
+    : graph(graph), threads(std::max(1u, std::thread::hardware_concurrency())), initial_clique(initial_clique),
+      best_size(0), outstanding(0), idle(0), shared_nodes(0), aborted(false), stop_reason(0)
+{
+    int n = graph.get_number_of_vertices();
+    number_of_words = (n + WORD_BITS - 1) / WORD_BITS;
+    if (graph.is_dense())
+    {
+        rows.resize(n);
+        for (int v = 0; v < n; ++v)
+            rows[v] = graph.get_row(v);
+    }
+    else if ((std::size_t)n * number_of_words * sizeof(word_t) <= MAX_MATRIX_BYTES)
+    {
+        rows.resize(n);
+        matrix.assign((std::size_t)n * number_of_words, 0);
+        for (int v = 0; v < n; ++v)
+        {
+            word_t *row = matrix.data() + (std::size_t)v * number_of_words;
+            for (int u : graph.get_neighbours(v))
+                row[u / WORD_BITS] |= word_t(1) << (u % WORD_BITS);
+            rows[v] = row;
+        }
+    }
+
+    VertexSet members(n);
+    for (int v : initial_clique)
+        members.set(v);
+    assert(graph.is_clique(members) && "Initial solution is not a clique.");
+}
+
+void BranchAndBound::set_stopping_criteria(const StoppingCriteria &criteria)
+{
+    stopping = StoppingPolicy(criteria);
+}
+
+const StoppingPolicy &BranchAndBound::get_stopping_policy() const
+{
+    return stopping;
+}
+
+void BranchAndBound::set_threads(int threads)
+{
+    this->threads = std::max(1, threads);
+}
+
+bool BranchAndBound::fits_in_memory() const
+{
+    return (int)rows.size() == graph.get_number_of_vertices();
+}
+
+BranchAndBound::Level &BranchAndBound::level(Worker &worker, int depth)
+{
+    Level &level = worker.levels[depth];
+    if (level.candidates.empty())
+    {
+        level.candidates.resize(number_of_words);
+        level.order.resize(graph.get_number_of_vertices());
+        level.colour.resize(graph.get_number_of_vertices());
+    }
+    return level;
+}
+
+int BranchAndBound::colour_sort(Worker &worker, int depth)
+{
+    Level &level = worker.levels[depth];
+    words_t &uncoloured = worker.uncoloured;
+    words_t &available = worker.available;
+    std::copy(level.candidates.begin(), level.candidates.end(), uncoloured.begin());
+    // A vertex coloured below min_colour cannot lead to a clique larger than the best one,
+    // so it is never branched on here (it stays a candidate for the children)
+    int min_colour = std::max(1, best_size.load(std::memory_order_relaxed) - (int)worker.current.size() + 1);
+    int count = 0;
+    int first_word = 0;
+    for (int k = 1; first_word < number_of_words; ++k)
+    {
+        std::copy(uncoloured.begin() + first_word, uncoloured.end(), available.begin() + first_word);
+        for (int w = first_word; w < number_of_words; ++w)
+        {
+            while (available[w])
+            {
+                int bit = __builtin_ctzll(available[w]);
+                int v = w * WORD_BITS + bit;
+                uncoloured[w] &= ~(word_t(1) << bit);
+                available[w] &= ~(word_t(1) << bit);
+                const word_t *row = rows[v];
+                for (int x = w; x < number_of_words; ++x)
+                    available[x] &= ~row[x];
+                if (k >= min_colour)
+                {
+                    level.order[count] = v;
+                    level.colour[count] = k;
+                    ++count;
+                }
+            }
+        }
+        while (first_word < number_of_words && uncoloured[first_word] == 0)
+            ++first_word;
+    }
+    return count;
+}
+
+void BranchAndBound::request_stop(StopReason reason)
+{
+    int none = (int)StopReason::None;
+    stop_reason.compare_exchange_strong(none, (int)reason);
+    aborted.store(true, std::memory_order_relaxed);
+}
+
+// Counts one node. The shared counters and the clock are only touched every clock_interval nodes.
+bool BranchAndBound::should_stop(Worker &worker)
+{
+    const StoppingCriteria &criteria = stopping.get_criteria();
+    if (++worker.nodes % criteria.clock_interval == 0)
+    {
+        long long nodes = shared_nodes.fetch_add(criteria.clock_interval, std::memory_order_relaxed) + criteria.clock_interval;
+        if (nodes >= criteria.max_iterations)
+            request_stop(StopReason::Iterations);
+        else if (stopping.elapsed() >= criteria.time_limit)
+            request_stop(StopReason::TimeLimit);
+        else if (stopping.shared_reason() != StopReason::None)
+            request_stop(stopping.shared_reason());
+        // Prune against cliques other solvers sharing the incumbent have found
+        int shared_best = criteria.incumbent ? criteria.incumbent->get_size() : 0;
+        int current = best_size.load(std::memory_order_relaxed);
+        while (shared_best > current && !best_size.compare_exchange_weak(current, shared_best, std::memory_order_relaxed))
+        {
+        }
+    }
+    return aborted.load(std::memory_order_relaxed);
+}
+
+void BranchAndBound::update_best(const std::vector<int> &clique, const Worker &worker)
+{
+    std::lock_guard<std::mutex> lock(best_mutex);
+    if ((int)clique.size() <= best_size.load(std::memory_order_relaxed))
+        return;
+    best = clique;
+    best_size.store(clique.size(), std::memory_order_relaxed);
+    // Nodes so far, for the trace: the shared count lags each worker by less than clock_interval
+    long long nodes = shared_nodes.load(std::memory_order_relaxed) + worker.nodes % stopping.get_criteria().clock_interval;
+    stopping.set_iterations(std::max(stopping.get_iterations(), nodes));
+    stopping.improve(clique.size());
+    if (stopping.target_reached())
+        request_stop(StopReason::Target);
+}
+
+void BranchAndBound::expand(Worker &worker, int depth)
+{
+    if (should_stop(worker))
+        return;
+    std::vector<int> &current = worker.current;
+    Level &parent = worker.levels[depth];
+    int count = colour_sort(worker, depth);
+    if (depth == 0)
+        worker.running_bound = std::min(worker.running_bound, count > 0 ? (int)current.size() + parent.colour[count - 1] : 0);
+    parent.donated = false;
+
+    for (int i = count - 1; i >= 0; --i)
+    {
+        if ((int)current.size() + parent.colour[i] <= best_size.load(std::memory_order_relaxed))
+            return;
+        if (depth == 0)
+            worker.running_bound = (int)current.size() + parent.colour[i];
+
+        parent.rest = i;
+        int v = parent.order[i];
+        current.push_back(v);
+        Level &next = level(worker, depth + 1);
+        const word_t *row = rows[v];
+        bool any = false;
+        for (int w = 0; w < number_of_words; ++w)
+        {
+            next.candidates[w] = parent.candidates[w] & row[w];
+            any |= next.candidates[w] != 0;
+        }
+        if (any)
+            expand(worker, depth + 1);
+        else if ((int)current.size() > best_size.load(std::memory_order_relaxed))
+            update_best(current, worker);
+        current.pop_back();
+        if (aborted.load(std::memory_order_relaxed))
+            return;
+        parent.candidates[v / WORD_BITS] &= ~(word_t(1) << (v % WORD_BITS));
+
+        if (idle.load(std::memory_order_relaxed) > 0)
+            donate(worker, depth);
+        // The rest of this node was handed over, now or while the child was expanded
+        if (parent.donated)
+            return;
+    }
+}
+
+// Someone has nothing to do: hand over the rest of the shallowest node on the stack that still
+// has branches left (the taker colours it again). Each donation answers one request in `idle`.
+void BranchAndBound::donate(Worker &worker, int depth)
+{
+    std::vector<int> &current = worker.current;
+    int base = (int)current.size() - depth;
+    for (int s = 0; s <= depth; ++s)
+    {
+        Level &level = worker.levels[s];
+        if (level.donated || level.rest == 0)
+            continue;
+        int bound = base + s + level.colour[level.rest - 1];
+        if (bound <= best_size.load(std::memory_order_relaxed))
+            continue;
+        int waiting = idle.load(std::memory_order_relaxed);
+        while (waiting > 0 && !idle.compare_exchange_weak(waiting, waiting - 1))
+        {
+        }
+        if (waiting == 0)
+            return;
+        // Vertices already branched on were removed; the one being branched on is still there
+        int v = level.order[level.rest];
+        words_t candidates = level.candidates;
+        candidates[v / WORD_BITS] &= ~(word_t(1) << (v % WORD_BITS));
+        push_task(worker, std::vector<int>(current.begin(), current.begin() + base + s), candidates, bound);
+        level.donated = true;
+        return;
+    }
+}
+
+void BranchAndBound::push_task(Worker &worker, const std::vector<int> &clique, const words_t &candidates, int bound)
+{
+    outstanding.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(Task{clique, candidates, bound});
+    }
+    // Taking idle_mutex orders the push before a sleeper's last look, so the wakeup is not lost
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+    }
+    work_available.notify_one();
+}
+
+bool BranchAndBound::has_task()
+{
+    for (const std::unique_ptr<Worker> &victim : workers)
+    {
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->tasks.empty())
+            return true;
+    }
+    return false;
+}
+
+// The newest task of worker `id`, or else the shallowest (largest) task of another worker
+bool BranchAndBound::take_task(int id, Task &task)
+{
+    int count = workers.size();
+    for (int k = 0; k < count; ++k)
+    {
+        Worker &victim = *workers[(id + k) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        auto taken = std::prev(victim.tasks.end());
+        if (k > 0)
+            taken = std::min_element(victim.tasks.begin(), victim.tasks.end(), [](const Task &a, const Task &b)
+                                     { return a.clique.size() < b.clique.size(); });
+        task = std::move(*taken);
+        victim.tasks.erase(taken);
+        return true;
+    }
+    return false;
+}
+
+void BranchAndBound::run_task(Worker &worker, Task &task)
+{
+    worker.current = task.clique;
+    Level &root = level(worker, 0);
+    std::copy(task.candidates.begin(), task.candidates.end(), root.candidates.begin());
+    worker.running_bound = task.bound;
+    if (task.bound > best_size.load(std::memory_order_relaxed))
+        expand(worker, 0);
+    if (aborted.load(std::memory_order_relaxed))
+        worker.unfinished_bound = std::max(worker.unfinished_bound, worker.running_bound);
+}
+
+void BranchAndBound::work(int id)
+{
+    Worker &worker = *workers[id];
+    Task task;
+    bool requested = false;
+    while (true)
+    {
+        if (take_task(id, task))
+        {
+            requested = false;
+            run_task(worker, task);
+            if (outstanding.fetch_sub(1) == 1)
+            {
+                // That was the last task: wake the sleepers so they see the search is over
+                {
+                    std::lock_guard<std::mutex> lock(idle_mutex);
+                }
+                work_available.notify_all();
+            }
+            continue;
+        }
+        if (outstanding.load() == 0)
+            break;
+        // Ask for one donation; ask again if every request was answered and the task went to someone else
+        if (!requested || idle.load() == 0)
+        {
+            idle.fetch_add(1);
+            requested = true;
+        }
+        // Sleep instead of spinning, so idle workers leave the cores to the busy ones
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        if (!has_task() && outstanding.load() != 0)
+            work_available.wait(lock);
+    }
+}
+
+ExactResult BranchAndBound::run()
+{
+    stopping.start();
+    int n = graph.get_number_of_vertices();
+    best = initial_clique;
+    best_size = best.size();
+    stopping.improve(best.size());
+    outstanding = 0;
+    idle = 0;
+    shared_nodes = 0;
+    aborted = false;
+    stop_reason = (int)StopReason::None;
+    if (stopping.target_reached())
+        request_stop(StopReason::Target);
+    if (!fits_in_memory())
+    {
+        stopping.stop((StopReason)stop_reason.load());
+        ExactResult result;
+        result.clique = best;
+        result.optimal = false;
+        result.upper_bound = n;
+        result.nodes = 0;
+        result.seconds = stopping.elapsed();
+        return result;
+    }
+
+    workers.clear();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.push_back(std::make_unique<Worker>());
+        Worker &worker = *workers.back();
+        // Depth never exceeds n, and references into `levels` must survive the recursion
+        worker.levels.resize(n + 1);
+        worker.uncoloured.resize(number_of_words);
+        worker.available.resize(number_of_words);
+        worker.current.reserve(n);
+    }
+
+    words_t all(number_of_words, 0);
+    for (int v = 0; v < n; ++v)
+        all[v / WORD_BITS] |= word_t(1) << (v % WORD_BITS);
+    push_task(*workers[0], {}, all, n);
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(&BranchAndBound::work, this, t);
+    work(0);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    long long nodes = 0;
+    int unfinished_bound = 0;
+    for (const std::unique_ptr<Worker> &worker : workers)
+    {
+        nodes += worker->nodes;
+        unfinished_bound = std::max(unfinished_bound, worker->unfinished_bound);
+    }
+    stopping.set_iterations(nodes);
+    stopping.stop((StopReason)stop_reason.load());
+
+    // With a shared incumbent the search may have pruned against a clique found elsewhere:
+    // then it proves nothing beats best_size, but `best` itself can be smaller
+    ExactResult result;
+    result.clique = best;
+    result.optimal = !aborted && (int)best.size() == best_size.load();
+    result.upper_bound = aborted ? std::max(unfinished_bound, best_size.load()) : best_size.load();
+    result.nodes = nodes;
+    result.seconds = stopping.elapsed();
+    return result;
+}
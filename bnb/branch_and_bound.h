@@ -0,0 +1,130 @@
+#ifndef BRANCH_AND_BOUND_H
+#define BRANCH_AND_BOUND_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../graph/graph.h"
+#include "../common/stopping.h"
+
+// Outcome of an exact search. When the search was cut short, `clique` is the best one
+// found and no clique is larger than `upper_bound`.
+struct ExactResult
+{
+    std::vector<int> clique;
+    bool optimal;
+    int upper_bound;
+    long long nodes;
+    double seconds;
+
+    int gap() const { return upper_bound - (int)clique.size(); }
+};
+
+// Exact maximum clique by branch and bound with bitset greedy colouring bounds (MCS/BBMC).
+// Candidates are coloured in vertex index order, so the graph's VertexOrdering (decreasing
+// degree unless reordered) decides the colouring, and branched on from the highest colour down.
+//
+// The search runs on a pool of worker threads with work stealing: every worker owns a deque
+// of subproblems, pops from its back and steals the shallowest subproblem of the others'. For
+// each idle worker a busy one hands over one subproblem, the rest of the shallowest node on its
+// stack that still has branches left; idle workers sleep until then. The size of the best
+// clique is shared through an atomic so every worker prunes against the global incumbent.
+//
+// The search needs a packed adjacency row per vertex. Dense graphs lend theirs; for a sparse one
+// the n * n / 64 words are built here, so pass a graph that is already reduced (reduce_graph) or
+// small. Above MAX_MATRIX_BYTES the matrix is not built and run() refuses: it returns the
+// initial clique with the trivial upper bound n (see fits_in_memory()).
+class BranchAndBound
+{
+private:
+    using words_t = std::vector<word_t, AlignedAllocator<word_t>>;
+
+    // Buffers of one depth of the search, allocated the first time that depth is reached
+    struct Level
+    {
+        words_t candidates;
+        std::vector<int> order;  // Candidates that can still improve on the best clique, by colour
+        std::vector<int> colour; // colour[i]: colours used up to and including order[i]
+        int rest = 0;            // order[0, rest) are still to be branched on
+        bool donated = false;    // The rest was handed over to an idle worker
+    };
+
+    // Expand the node with clique `clique` and candidate set `candidates`;
+    // no clique found under it is larger than `bound`
+    struct Task
+    {
+        std::vector<int> clique;
+        words_t candidates;
+        int bound;
+    };
+
+    struct Worker
+    {
+        std::vector<Level> levels; // One per depth; never resized, so references into it stay valid
+        words_t uncoloured;
+        words_t available;
+        std::vector<int> current;
+        std::mutex mutex; // Guards tasks
+        std::deque<Task> tasks;
+        long long nodes = 0;
+        int running_bound = 0;    // Bound of what is left of the task being expanded
+        int unfinished_bound = 0; // Largest bound of the work this worker dropped on a stop
+    };
+
+    static constexpr std::size_t MAX_MATRIX_BYTES = std::size_t(1) << 30;
+
+    const Graph &graph;
+    int number_of_words;
+    int threads;
+    std::vector<const word_t *> rows; // Adjacency rows, the graph's own when it is dense; empty if too large
+    words_t matrix;                   // Backing store of `rows` for sparse graphs
+    std::vector<int> initial_clique;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex best_mutex; // Guards best and stopping.improve
+    std::vector<int> best;
+    std::atomic<int> best_size;
+    std::atomic<int> outstanding; // Tasks pushed and not finished yet
+    std::atomic<int> idle;        // Donations asked for by workers looking for a task
+    std::mutex idle_mutex;        // Pairs with work_available
+    std::condition_variable work_available; // Idle workers sleep here until a task is pushed or the search ends
+    std::atomic<long long> shared_nodes;
+    std::atomic<bool> aborted;
+    std::atomic<int> stop_reason;
+    StoppingPolicy stopping; // Counts search nodes; no limits unless set
+
+    Level &level(Worker &worker, int depth);
+    // Greedy sequential colouring of the candidates at `depth`; returns how many were kept in order
+    int colour_sort(Worker &worker, int depth);
+    void expand(Worker &worker, int depth);
+    bool should_stop(Worker &worker);
+    void request_stop(StopReason reason);
+    void update_best(const std::vector<int> &clique, const Worker &worker);
+    void donate(Worker &worker, int depth);
+    void push_task(Worker &worker, const std::vector<int> &clique, const words_t &candidates, int bound);
+    bool take_task(int id, Task &task);
+    bool has_task();
+    void run_task(Worker &worker, Task &task);
+    void work(int id);
+
+public:
+    // initial_clique, if given, is the starting lower bound (e.g. the best heuristic clique)
+    BranchAndBound(const Graph &graph, const std::vector<int> &initial_clique = {});
+
+    // The time limit goes in criteria.time_limit, max_iterations limits search nodes and a
+    // target stops the search once it is reached; stall_iterations is not used. With
+    // criteria.incumbent the search also prunes against cliques found by other solvers.
+    void set_stopping_criteria(const StoppingCriteria &criteria);
+    const StoppingPolicy &get_stopping_policy() const;
+    // Number of worker threads; defaults to the hardware concurrency
+    void set_threads(int threads);
+    // False when the graph is sparse and its adjacency matrix would exceed MAX_MATRIX_BYTES
+    bool fits_in_memory() const;
+
+    ExactResult run();
+};
+
+#endif // BRANCH_AND_BOUND_H
@@ -0,0 +1,52 @@
+#ifndef INCUMBENT_H
+#define INCUMBENT_H
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Best clique shared by solvers running side by side. The size is an atomic so hot loops can
+// read it for free; the vertices are only published when a solver finishes a run.
+class SharedIncumbent
+{
+private:
+    std::atomic<int> size;
+    std::atomic<bool> stopped;
+    std::mutex mutex; // Guards clique
+    std::vector<int> clique;
+
+public:
+    SharedIncumbent() : size(0), stopped(false) {}
+
+    int get_size() const { return this->size.load(std::memory_order_relaxed); }
+
+    // Announce that some solver holds a clique of `objective` vertices
+    void raise(int objective)
+    {
+        int current = this->size.load(std::memory_order_relaxed);
+        while (objective > current and !this->size.compare_exchange_weak(current, objective, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Publish a clique; true if it is larger than every clique published before
+    bool offer(const std::vector<int> &candidate)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->raise(candidate.size());
+        if (candidate.size() <= this->clique.size())
+            return false;
+        this->clique = candidate;
+        return true;
+    }
+
+    std::vector<int> get_clique()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->clique;
+    }
+
+    void request_stop() { this->stopped.store(true, std::memory_order_relaxed); }
+    bool stop_requested() const { return this->stopped.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "stopping.h"
+
+// Operation counters and phase timers for the solvers. They are only compiled in with
+// -DCLIQUE_PROFILE (make PROFILE=1); otherwise the PROFILE_* macros expand to nothing and a
+// run's profile stays all zeros.
+
+enum class Counter
+{
+    AdjacencyQueries,   // is_edge calls plus adjacency rows or neighbour lists scanned
+    Repairs,            // GA individuals turned into cliques
+    RepairRemovals,     // Vertices the repairs dropped
+    Crossovers,
+    MutatedBits,
+    AcceptedMoves,      // SA swaps accepted
+    RejectedMoves,      // SA swaps rejected
+    CandidatesExamined, // Neighbourhood size: SA vertices tried per move, TS add and swap candidates per move
+    AddMoves,
+    SwapMoves,
+    DropMoves,
+    Restarts,           // TS stall escapes
+    Count
+};
+
+// Phases may nest: GA repairs also count inside Initialisation and TS restarts inside Moves.
+// Time spent in OpenMP loops is summed over the threads.
+enum class Phase
+{
+    Initialisation,
+    Variation, // Crossover and mutation
+    Repair,
+    Selection,
+    Annealing,
+    Extension, // SA growing the window once it is a clique
+    Moves,
+    Restart,
+    Count
+};
+
+class SolverProfile
+{
+private:
+    static constexpr int COUNTERS = (int)Counter::Count;
+    static constexpr int PHASES = (int)Phase::Count;
+
+    // One per OpenMP thread, on its own cache line, so counting never shares a line
+    struct alignas(64) Slot
+    {
+        long long counters[COUNTERS] = {};
+        double seconds[PHASES] = {};
+    };
+
+    std::string solver;
+    std::vector<Slot> slots;
+
+    static const char *counter_name(int counter)
+    {
+        static const char *names[COUNTERS] = {"adjacency_queries", "repairs", "repair_removals", "crossovers",
+                                              "mutated_bits", "accepted_moves", "rejected_moves",
+                                              "candidates_examined", "add_moves", "swap_moves", "drop_moves",
+                                              "restarts"};
+        return names[counter];
+    }
+
+    static const char *phase_name(int phase)
+    {
+        static const char *names[PHASES] = {"initialisation", "variation", "repair", "selection", "annealing",
+                                            "extension", "moves", "restart"};
+        return names[phase];
+    }
+
+public:
+    explicit SolverProfile(const std::string &solver) : solver(solver), slots(1) {}
+
+    // Clear everything at the start of a run; `threads` is the largest OpenMP team it uses
+    void reset(int threads = 1) { this->slots.assign(threads, Slot()); }
+
+    void count(Counter counter, long long amount = 1)
+    {
+        this->slots[omp_get_thread_num()].counters[(int)counter] += amount;
+    }
+
+    void add_time(Phase phase, double seconds)
+    {
+        this->slots[omp_get_thread_num()].seconds[(int)phase] += seconds;
+    }
+
+    long long get_count(Counter counter) const
+    {
+        long long total = 0;
+        for (const Slot &slot : this->slots)
+            total += slot.counters[(int)counter];
+        return total;
+    }
+
+    double get_seconds(Phase phase) const
+    {
+        double total = 0.0;
+        for (const Slot &slot : this->slots)
+            total += slot.seconds[(int)phase];
+        return total;
+    }
+
+    // One JSON object: the run's iterations and best from `stopping`, every counter and phase, and
+    // the convergence trace of the run's criteria (if it has one) as [seconds, iteration, best] triples
+    void write_json(std::ostream &out, const StoppingPolicy &stopping) const
+    {
+        out << std::setprecision(9) << "{\"solver\":\"" << this->solver << "\",\"iterations\":" << stopping.get_iterations()
+            << ",\"best\":" << stopping.get_best() << ",\"time_to_best\":" << stopping.get_time_to_best() << ",\"counters\":{";
+        for (int c = 0; c < COUNTERS; ++c)
+            out << (c ? "," : "") << "\"" << counter_name(c) << "\":" << this->get_count((Counter)c);
+        out << "},\"phases\":{";
+        for (int p = 0; p < PHASES; ++p)
+            out << (p ? "," : "") << "\"" << phase_name(p) << "\":" << this->get_seconds((Phase)p);
+        out << "},\"trajectory\":[";
+        if (const ConvergenceTrace *trace = stopping.get_criteria().trace)
+        {
+            for (std::size_t i = 0; i < trace->size(); ++i)
+                out << (i ? "," : "") << "[" << (*trace)[i].seconds << "," << (*trace)[i].iteration << ","
+                    << (*trace)[i].best << "]";
+        }
+        out << "]}";
+    }
+
+    // Columns of csv_row; the trajectory is left out
+    static std::string csv_header()
+    {
+        std::string header = "solver,iterations,best,time_to_best";
+        for (int c = 0; c < COUNTERS; ++c)
+            header += std::string(",") + counter_name(c);
+        for (int p = 0; p < PHASES; ++p)
+            header += std::string(",seconds_") + phase_name(p);
+        return header;
+    }
+
+    std::string csv_row(const StoppingPolicy &stopping) const
+    {
+        std::ostringstream row;
+        row << std::setprecision(9) << this->solver << "," << stopping.get_iterations() << "," << stopping.get_best()
+            << "," << stopping.get_time_to_best();
+        for (int c = 0; c < COUNTERS; ++c)
+            row << "," << this->get_count((Counter)c);
+        for (int p = 0; p < PHASES; ++p)
+            row << "," << this->get_seconds((Phase)p);
+        return row.str();
+    }
+};
+
+// Adds the time from construction to destruction to one phase
+class PhaseTimer
+{
+private:
+    using clock = std::chrono::steady_clock;
+    SolverProfile &profile;
+    Phase phase;
+    clock::time_point start;
+
+public:
+    PhaseTimer(SolverProfile &profile, Phase phase) : profile(profile), phase(phase), start(clock::now()) {}
+    ~PhaseTimer() { this->profile.add_time(this->phase, std::chrono::duration<double>(clock::now() - this->start).count()); }
+};
+
+#ifdef CLIQUE_PROFILE
+#define PROFILE_COUNT(profile, counter, amount) (profile).count(counter, amount)
+// Times the rest of the enclosing block; one per block
+#define PROFILE_PHASE(profile, phase) PhaseTimer profile_phase_timer(profile, phase)
+#else
+#define PROFILE_COUNT(profile, counter, amount) ((void)0)
+#define PROFILE_PHASE(profile, phase) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+#include <cstdint>
+#include <limits>
+
+// Counter-based generator: output i of stream s is a SplitMix64 hash of (seed, s, i).
+// Streams are independent of each other and of the order they are consumed in, so work
+// split across threads by stream draws the same numbers for any thread count.
+class CounterRng
+{
+private:
+    std::uint64_t key;
+    std::uint64_t counter;
+
+    static std::uint64_t mix(std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    using result_type = std::uint64_t;
+
+    CounterRng(std::uint64_t seed, std::uint64_t stream)
+        : key(mix(seed + 0x9e3779b97f4a7c15ull) ^ mix(stream ^ 0x632be59bd9b4e019ull)), counter(0) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        return mix(this->key + 0x9e3779b97f4a7c15ull * ++this->counter);
+    }
+
+    // Uniform double in [0, 1)
+    double uniform()
+    {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+};
+
+// Stream number for item `index` of step `step` (a generation, a restart, ...)
+inline std::uint64_t stream_id(std::uint64_t step, std::uint64_t index)
+{
+    return (step << 32) | (index & 0xffffffffull);
+}
+
+#endif
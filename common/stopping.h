@@ -0,0 +1,149 @@
+#ifndef STOPPING_H
+#define STOPPING_H
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "incumbent.h"
+#include "trace.h"
+
+// When a solver should stop. Every limit is off unless set; an "iteration" is the
+// solver's own unit of work (a generation, a temperature step, a tabu move).
+struct StoppingCriteria
+{
+    double time_limit = std::numeric_limits<double>::infinity(); // Seconds of wall-clock time
+    long long max_iterations = std::numeric_limits<long long>::max();
+    int target = std::numeric_limits<int>::max(); // Stop once a clique of this size is found
+    long long stall_iterations = std::numeric_limits<long long>::max(); // Iterations without improvement
+    int clock_interval = 64; // The clock is read once every clock_interval iterations
+    // Solvers racing on the same instance: improvements are published here, and the solver
+    // stops when the shared best reaches the target or someone requests a stop
+    SharedIncumbent *incumbent = nullptr;
+    // Every improvement is recorded here (elapsed seconds, iteration, best); start() clears it
+    ConvergenceTrace *trace = nullptr;
+};
+
+enum class StopReason
+{
+    None, // Still running, or the solver ended on its own (SA reaching its end temperature, ...)
+    TimeLimit,
+    Iterations,
+    Target,
+    Stall,
+    Interrupted // Another solver sharing the incumbent asked everyone to stop
+};
+
+// Tracks one run against a StoppingCriteria. Solvers call start() before their main loop,
+// should_stop() once per iteration and improve() whenever their best objective grows.
+// should_stop() is a few integer compares; the clock is only read every clock_interval calls.
+class StoppingPolicy
+{
+private:
+    using clock = std::chrono::steady_clock;
+
+    StoppingCriteria criteria;
+    clock::time_point start_time;
+    long long iterations;
+    long long last_improvement;
+    int best;
+    double time_to_best;
+    double time_to_target;
+    StopReason reason;
+
+public:
+    explicit StoppingPolicy(const StoppingCriteria &criteria = StoppingCriteria())
+        : criteria(criteria), iterations(0), last_improvement(0), best(0), time_to_best(0.0),
+          time_to_target(-1.0), reason(StopReason::None) {}
+
+    const StoppingCriteria &get_criteria() const { return this->criteria; }
+
+    void start()
+    {
+        this->start_time = clock::now();
+        this->iterations = 0;
+        this->last_improvement = 0;
+        this->best = 0;
+        this->time_to_best = 0.0;
+        this->time_to_target = -1.0;
+        this->reason = StopReason::None;
+        if (this->criteria.trace)
+            this->criteria.trace->clear();
+    }
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(clock::now() - this->start_time).count();
+    }
+
+    // Counts one iteration; true once any limit is hit, and from then on
+    bool should_stop()
+    {
+        if (this->reason != StopReason::None)
+            return true;
+        if (this->best >= this->criteria.target)
+            this->reason = StopReason::Target;
+        else if (this->iterations >= this->criteria.max_iterations)
+            this->reason = StopReason::Iterations;
+        else if (this->iterations - this->last_improvement >= this->criteria.stall_iterations)
+            this->reason = StopReason::Stall;
+        else if (this->iterations % this->criteria.clock_interval == 0)
+        {
+            if (this->elapsed() >= this->criteria.time_limit)
+                this->reason = StopReason::TimeLimit;
+            else
+                this->reason = this->shared_reason();
+        }
+        ++this->iterations;
+        return this->reason != StopReason::None;
+    }
+
+    // Report the solver's best objective so far; only increases count as improvements
+    void improve(int objective)
+    {
+        if (objective <= this->best)
+            return;
+        this->best = objective;
+        if (this->criteria.incumbent)
+            this->criteria.incumbent->raise(objective);
+        this->last_improvement = this->iterations;
+        this->time_to_best = this->elapsed();
+        if (objective >= this->criteria.target && this->time_to_target < 0.0)
+            this->time_to_target = this->time_to_best;
+        if (this->criteria.trace)
+            this->criteria.trace->record(this->time_to_best, this->iterations, objective);
+    }
+
+    // For solvers that count work in several threads and decide to stop on their own: set the
+    // iterations done so far (improve() records them with each new best) and why they stopped
+    void set_iterations(long long count) { this->iterations = count; }
+    void stop(StopReason reason) { this->reason = reason; }
+
+    // Why the solvers sharing the incumbent want this one to stop, or None
+    StopReason shared_reason() const
+    {
+        const SharedIncumbent *shared = this->criteria.incumbent;
+        if (!shared)
+            return StopReason::None;
+        if (shared->stop_requested())
+            return StopReason::Interrupted;
+        if (shared->get_size() >= this->criteria.target)
+            return StopReason::Target;
+        return StopReason::None;
+    }
+
+    // Best objective of this solver or of any solver sharing the incumbent
+    int get_shared_best() const
+    {
+        return this->criteria.incumbent ? std::max(this->best, this->criteria.incumbent->get_size()) : this->best;
+    }
+
+    bool target_reached() const { return this->best >= this->criteria.target; }
+    long long get_iterations() const { return this->iterations; }
+    int get_best() const { return this->best; }
+    // Seconds from start() to the last improvement
+    double get_time_to_best() const { return this->time_to_best; }
+    // Seconds from start() until the target was first reached, or -1 if it never was
+    double get_time_to_target() const { return this->time_to_target; }
+    StopReason get_reason() const { return this->reason; }
+};
+
+#endif
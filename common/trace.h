@@ -0,0 +1,77 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A new best objective and when it was reached
+struct TracePoint
+{
+    double seconds;
+    long long iteration;
+    int best;
+};
+
+// Convergence trace of one run: every improvement of the best objective. The buffer is
+// allocated up front and used as a ring, so recording a point never allocates; when it is
+// full the oldest points are overwritten and counted in get_dropped(). Write it out after
+// the run, not during it.
+class ConvergenceTrace
+{
+private:
+    std::vector<TracePoint> points;
+    std::size_t next;  // Slot of the next point
+    std::size_t count; // Points held, at most points.size()
+    long long dropped;
+
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+    // Columns of to_csv, after the caller's prefix
+    static constexpr const char *CSV_COLUMNS = "elapsed,iteration,best_size";
+
+    explicit ConvergenceTrace(std::size_t capacity = DEFAULT_CAPACITY)
+        : points(std::max<std::size_t>(1, capacity)), next(0), count(0), dropped(0) {}
+
+    void clear()
+    {
+        this->next = 0;
+        this->count = 0;
+        this->dropped = 0;
+    }
+
+    void record(double seconds, long long iteration, int best)
+    {
+        this->points[this->next] = TracePoint{seconds, iteration, best};
+        this->next = (this->next + 1) % this->points.size();
+        if (this->count < this->points.size())
+            ++this->count;
+        else
+            ++this->dropped;
+    }
+
+    std::size_t size() const { return this->count; }
+    long long get_dropped() const { return this->dropped; }
+
+    // Point i, oldest first
+    const TracePoint &operator[](std::size_t i) const
+    {
+        return this->points[(this->next + this->points.size() - this->count + i) % this->points.size()];
+    }
+
+    // One "prefix,elapsed,iteration,best_size" line per point, oldest first, without a final newline
+    std::string to_csv(const std::string &prefix) const
+    {
+        std::ostringstream out;
+        out.precision(9);
+        for (std::size_t i = 0; i < this->count; ++i)
+        {
+            const TracePoint &point = (*this)[i];
+            out << (i ? "\n" : "") << prefix << "," << point.seconds << "," << point.iteration << "," << point.best;
+        }
+        return out.str();
+    }
+};
+
+#endif
@@ -1,258 +1,324 @@
-#include <bitset>
 #include <random>
 #include <vector>
+#include <cmath>
 #include <iostream>
 #include "ga.h"
 
-std::bitset<NUM_MAX_VERTICES> GeneticAlgorithm::random_individual(int num_vertices)
+// Stream indices within a generation; offspring pairs use their own pair index
+constexpr std::uint64_t SELECTION_STREAM = 0xffffffffull;
+// Step number of the streams that build the initial population
+constexpr std::uint64_t INITIAL_POPULATION_STEP = 0xffffffffull;
+
+void GeneticAlgorithm::random_individual(VertexSet &ind, CounterRng &rng)
 {
-    std::bitset<NUM_MAX_VERTICES> ind;
-    for (int i = 0; i < num_vertices; ++i)
+    for (int w = 0; w < ind.get_number_of_words(); ++w)
     {
-        ind[i] = gen() % 2;
+        ind.data()[w] = rng();
     }
+    ind.mask_tail();
     repair_clique(ind);
-    return ind;
 }
 
 // Fitness function: return clique size if valid, otherwise 0
-int GeneticAlgorithm::fitness(const std::bitset<NUM_MAX_VERTICES> &ind)
+int GeneticAlgorithm::fitness(const VertexSet &ind)
 {
-
-    std::vector<int> vertices;
-    for (int i = 0; i < graph.get_number_of_vertices(); ++i)
-    {
-        if (ind[i])
-            vertices.push_back(i);
-    }
-    assert(is_clique(vertices) and (vertices.size() == ind.count()) and "ERROR: Invalid clique");
+    assert(is_clique(ind) and "ERROR: Invalid clique");
     return ind.count();
 }
 
 // Check if the selected vertices form a clique in the graph
-bool GeneticAlgorithm::is_clique(const std::vector<int> &vertices)
+bool GeneticAlgorithm::is_clique(const VertexSet &vertices)
+{
+    return graph.is_clique(vertices);
+}
+
+void GeneticAlgorithm::exchange_segment(const VertexSet &parent1, const VertexSet &parent2, VertexSet &child1, VertexSet &child2, int begin, int end)
 {
-    for (size_t i = 0; i < vertices.size(); ++i)
+    const word_t *p1 = parent1.data(), *p2 = parent2.data();
+    word_t *c1 = child1.data(), *c2 = child2.data();
+    for (int w = 0; w < parent1.get_number_of_words(); ++w)
     {
-        for (size_t j = i + 1; j < vertices.size(); ++j)
-        {
-            if (!graph.is_edge(vertices[i], vertices[j]))
-            {
-                return false;
-            }
-        }
+        // Bits of word w inside [begin, end): all or nothing except at the two boundary words
+        int lo = std::max(begin, w * WORD_BITS) - w * WORD_BITS;
+        int hi = std::min(end, (w + 1) * WORD_BITS) - w * WORD_BITS;
+        word_t mask = 0;
+        if (lo < hi)
+            mask = (hi - lo == WORD_BITS ? ~word_t(0) : ((word_t(1) << (hi - lo)) - 1)) << lo;
+        c1[w] = (p1[w] & ~mask) | (p2[w] & mask);
+        c2[w] = (p2[w] & ~mask) | (p1[w] & mask);
     }
-    return true;
 }
 
-// Single-point crossover to generate a child individual
-std::pair<std::bitset<NUM_MAX_VERTICES>, std::bitset<NUM_MAX_VERTICES>> GeneticAlgorithm::crossover(const std::bitset<NUM_MAX_VERTICES> &parent1, const std::bitset<NUM_MAX_VERTICES> &parent2)
+void GeneticAlgorithm::crossover(const VertexSet &parent1, const VertexSet &parent2, VertexSet &child1, VertexSet &child2, CounterRng &rng)
 {
-    int point = gen() % graph.get_number_of_vertices();
-    std::bitset<NUM_MAX_VERTICES> child1, child2;
-    for (int i = 0; i < point; ++i)
+    int num_vertices = graph.get_number_of_vertices();
+    PROFILE_COUNT(profile, Counter::Crossovers, 1);
+    switch (crossover_operator)
     {
-        child1[i] = parent1[i];
-        child2[i] = parent2[i];
-    }
-    for (int i = point; i < graph.get_number_of_vertices(); ++i)
+    case CrossoverOperator::SinglePoint:
+        exchange_segment(parent1, parent2, child1, child2, rng() % num_vertices, num_vertices);
+        break;
+    case CrossoverOperator::TwoPoint:
     {
-        child1[i] = parent2[i];
-        child2[i] = parent1[i];
+        int a = rng() % num_vertices, b = rng() % num_vertices;
+        exchange_segment(parent1, parent2, child1, child2, std::min(a, b), std::max(a, b));
+        break;
+    }
+    case CrossoverOperator::Uniform:
+        for (int w = 0; w < parent1.get_number_of_words(); ++w)
+        {
+            word_t mask = rng();
+            child1.data()[w] = (parent1.data()[w] & mask) | (parent2.data()[w] & ~mask);
+            child2.data()[w] = (parent2.data()[w] & mask) | (parent1.data()[w] & ~mask);
+        }
+        break;
+    case CrossoverOperator::CliqueAware:
+        // The intersection keeps the shared partial clique, the union merges both cliques
+        for (int w = 0; w < parent1.get_number_of_words(); ++w)
+        {
+            child1.data()[w] = parent1.data()[w] & parent2.data()[w];
+            child2.data()[w] = parent1.data()[w] | parent2.data()[w];
+        }
+        break;
     }
-    return {child1, child2};
 }
 
-// Mutation: Flip a random bit in the individual
-void GeneticAlgorithm::mutate(std::bitset<NUM_MAX_VERTICES> &individual)
+// Geometric skipping: the gap to the next flipped bit is Geometric(rate), so only flipped bits cost a draw
+void GeneticAlgorithm::mutate(VertexSet &individual, CounterRng &rng)
 {
-    int index = gen() % graph.get_number_of_vertices();
-    individual.flip(index);
+    int num_vertices = graph.get_number_of_vertices();
+    if (log_keep_probability == 0.0)
+        return;
+    double position = 0.0;
+    while (true)
+    {
+        position += std::floor(std::log(1.0 - rng.uniform()) / log_keep_probability);
+        if (position >= num_vertices)
+            return;
+        individual.flip((int)position);
+        PROFILE_COUNT(profile, Counter::MutatedBits, 1);
+        position += 1.0;
+    }
 }
 
-void GeneticAlgorithm::generate_offspring(std::vector<std::bitset<NUM_MAX_VERTICES>> &prev_population)
+void GeneticAlgorithm::generate_offspring()
 {
-    while ((int)prev_population.size() < 2 * population_size)
+    // Pair i writes children 2i and 2i+1 after the parents and draws from its own stream,
+    // so the result does not depend on which thread runs which pair
+    int num_pairs = population_size / 2;
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < num_pairs; ++i)
     {
-        int idx_parent1 = gen() % population_size;
-        int idx_parent2 = gen() % population_size;
-
-        std::bitset<NUM_MAX_VERTICES> parent1 = population[idx_parent1];
-        std::bitset<NUM_MAX_VERTICES> parent2 = population[idx_parent2];
-        std::bitset<NUM_MAX_VERTICES> child1, child2;
+        CounterRng rng(seed, stream_id(current_generation, i));
+        const VertexSet &parent1 = population[rng() % population_size];
+        const VertexSet &parent2 = population[rng() % population_size];
+        int slot1 = population_size + 2 * i, slot2 = slot1 + 1;
+        VertexSet &child1 = population[slot1];
+        VertexSet &child2 = population[slot2];
 
-        if (this->crossover_probability < dist(gen))
-        {
-            auto [c1, c2] = crossover(parent1, parent2);
-            child1 = c1;
-            child2 = c2;
-        }
-        else
-        {
-            child1 = parent1;
-            child2 = parent2;
-        }
-        if (this->mutation_probability < dist(gen))
-        {
-            mutate(child1);
-        }
-        if (this->mutation_probability < dist(gen))
         {
-            mutate(child2);
+            PROFILE_PHASE(profile, Phase::Variation);
+            if (rng.uniform() < this->crossover_probability)
+            {
+                crossover(parent1, parent2, child1, child2, rng);
+            }
+            else
+            {
+                child1 = parent1;
+                child2 = parent2;
+            }
+            mutate(child1, rng);
+            mutate(child2, rng);
         }
         repair_clique(child1);
         repair_clique(child2);
-        prev_population.push_back(child1);
-        prev_population.push_back(child2);
+        fitnesses[slot1] = fitness(child1);
+        fitnesses[slot2] = fitness(child2);
+    }
+    // With an odd population the last slot gets a repaired copy of a random parent
+    if (population_size % 2 != 0)
+    {
+        CounterRng rng(seed, stream_id(current_generation, num_pairs));
+        int parent = rng() % population_size;
+        population[2 * population_size - 1] = population[parent];
+        fitnesses[2 * population_size - 1] = fitnesses[parent];
     }
 }
 
-void GeneticAlgorithm::select_new_population(std::vector<std::bitset<NUM_MAX_VERTICES>> &parents_and_offspring)
+// Three-way tournaments without replacement over parents and offspring; winners are copied
+// into the spare buffer, which then becomes the population
+void GeneticAlgorithm::select_new_population()
 {
-    std::vector<int> fitnesses(2 * population_size);
-#pragma omp parallel for
-    for (int i = 0; i < 2 * population_size; i++)
-    {
-        fitnesses[i] = fitness(parents_and_offspring[i]);
-    }
-    std::vector<bool> selected(2 * population_size, false);
+    PROFILE_PHASE(profile, Phase::Selection);
+    CounterRng rng(seed, stream_id(current_generation, SELECTION_STREAM));
+    std::fill(selected.begin(), selected.end(), 0);
     for (int i = 0; i < population_size; i++)
     {
-        std::set<int> participants;
+        int participants[3];
         int winner_fitness = 0;
         int winner_idx = -1;
-        for (size_t j = 0; j < 3; j++)
+        for (int j = 0; j < 3; j++)
         {
-            int idx = gen() % (2 * population_size);
-            while (selected[idx] || participants.find(idx) != participants.end())
+            int idx = rng() % (2 * population_size);
+            while (selected[idx] || std::find(participants, participants + j, idx) != participants + j)
             {
-                idx = gen() % (2 * population_size);
+                idx = rng() % (2 * population_size);
             }
-            participants.insert(idx);
+            participants[j] = idx;
             if (fitnesses[idx] >= winner_fitness)
             {
                 winner_fitness = fitnesses[idx];
                 winner_idx = idx;
             }
         }
-        selected[winner_idx] = true;
-        population.push_back(parents_and_offspring[winner_idx]);
+        selected[winner_idx] = 1;
+        next_population[i] = population[winner_idx];
+        next_fitnesses[i] = winner_fitness;
     }
+    std::swap(population, next_population);
+    std::swap(fitnesses, next_fitnesses);
 }
 
 // Generate the next generation of individuals
 void GeneticAlgorithm::next_generation()
 {
-    std::vector<std::bitset<NUM_MAX_VERTICES>> parents_and_offspring = population;
-    generate_offspring(parents_and_offspring);
-    population.clear();
-    select_new_population(parents_and_offspring);
+    generate_offspring();
+    select_new_population();
 }
 
-void GeneticAlgorithm::repair_clique(std::bitset<NUM_MAX_VERTICES> &individual)
+void GeneticAlgorithm::repair_clique(VertexSet &individual)
 {
-    std::vector<int> vertices;
-    for (int i = 0; i < graph.get_number_of_vertices(); ++i)
-    {
-        if (individual[i])
-            vertices.push_back(i);
-    }
-    std::map<int, std::vector<int>> neighbours;
-    for (size_t i = 0; i < vertices.size(); ++i)
-    {
-        for (size_t j = i + 1; j < vertices.size(); ++j)
-        {
-            if (graph.is_edge(vertices[i], vertices[j]))
-            {
-                neighbours[vertices[i]].push_back(vertices[j]);
-                neighbours[vertices[j]].push_back(vertices[i]);
-            }
-        }
-        if (neighbours.find(vertices[i]) == neighbours.end())
-            neighbours[vertices[i]] = std::vector<int>();
-    }
-    while (!is_clique(vertices))
+    PROFILE_PHASE(profile, Phase::Repair);
+    PROFILE_COUNT(profile, Counter::Repairs, 1);
+    RepairWorkspace &workspace = workspaces[omp_get_thread_num()];
+    std::vector<int> &induced_degree = workspace.induced_degree;
+    const word_t *members = individual.data();
+
+    int size = 0;
+    individual.for_each([&](int v)
+                        {
+        induced_degree[v] = graph.count_neighbours_in(v, members);
+        ++size; });
+    PROFILE_COUNT(profile, Counter::AdjacencyQueries, size);
+
+    // The set is a clique exactly when its minimum induced degree is size - 1
+    while (size > 0)
     {
-        assert(vertices.size() == neighbours.size() and "ERROR: Invalid clique");
-        int min_degree = graph.get_number_of_vertices() + 10;
+        int min_degree = size;
         int vertex_to_remove = -1;
-        for (const auto &[vertex, neighbour_list] : neighbours)
-        {
-            if ((int)neighbour_list.size() < min_degree)
-            {
-                min_degree = neighbour_list.size();
-                vertex_to_remove = vertex;
-            }
-        }
-        if (vertex_to_remove == -1)
-        {
-            std::cout << "ERROR: No vertex to remove" << std::endl;
-            std::cout << vertices.size() << std::endl;
-            std::cout << neighbours.size() << std::endl;
-            std::cout << min_degree << std::endl;
-            std::cout << "Vertices:" << std::endl;
-            for (const auto &[vertex, neighbour_list] : neighbours)
+        individual.for_each([&](int v)
+                            {
+            if (induced_degree[v] < min_degree)
             {
-                std::cout << vertex << " " << neighbour_list.size() << std::endl;
-            }
-        }
-        assert(vertex_to_remove != -1 and "ERROR: No vertex to remove");
+                min_degree = induced_degree[v];
+                vertex_to_remove = v;
+            } });
+        if (min_degree == size - 1)
+            break;
+
+        individual.reset(vertex_to_remove);
+        --size;
+        PROFILE_COUNT(profile, Counter::RepairRemovals, 1);
+        PROFILE_COUNT(profile, Counter::AdjacencyQueries, 1);
+        graph.for_each_neighbour_in(vertex_to_remove, members, [&](int u)
+                                    { --induced_degree[u]; });
+    }
 
-        individual[vertex_to_remove] = 0;
-        vertices.erase(std::remove(vertices.begin(), vertices.end(), vertex_to_remove), vertices.end());
-        neighbours.erase(vertex_to_remove);
-        for (auto &[vertex, neighbour_list] : neighbours)
+    // Greedy extension: lower indices have higher degree, so take candidates in increasing order
+    VertexSet &candidates = workspace.candidates;
+    candidates.fill();
+    individual.for_each([&](int v)
+                        { graph.intersect_with_neighbours(v, candidates); });
+    PROFILE_COUNT(profile, Counter::AdjacencyQueries, size);
+    for (int w = 0; w < candidates.get_number_of_words(); ++w)
+    {
+        while (candidates.data()[w])
         {
-            neighbour_list.erase(std::remove_if(neighbour_list.begin(), neighbour_list.end(),
-                                                [vertex_to_remove](int v)
-                                                { return v == vertex_to_remove; }),
-                                 neighbour_list.end());
+            int v = w * WORD_BITS + __builtin_ctzll(candidates.data()[w]);
+            individual.set(v);
+            graph.intersect_with_neighbours(v, candidates);
+            PROFILE_COUNT(profile, Counter::AdjacencyQueries, 1);
         }
     }
 }
 
 // Constructor: Initializes the genetic algorithm with the given graph, population size, mutation rate, and number of generations
-GeneticAlgorithm::GeneticAlgorithm(const Graph &g, int pop_size, double crossover_probability, double mutation_probability, int gens)
-    : graph(g), population_size(pop_size), crossover_probability(crossover_probability), mutation_probability(mutation_probability), generations(gens), gen(rd()), dist(0.0, 1.0) {}
+GeneticAlgorithm::GeneticAlgorithm(const Graph &g, int pop_size, double crossover_probability, double mutation_probability, int gens,
+                                   CrossoverOperator crossover_operator, std::uint64_t seed)
+    : graph(g), population_size(pop_size), crossover_probability(crossover_probability), mutation_probability(mutation_probability),
+      crossover_operator(crossover_operator), seed(seed), current_generation(0),
+      stopping(StoppingCriteria{.max_iterations = gens}), profile("ga")
+{
+    double bit_rate = std::clamp(mutation_probability, 0.0, 1.0);
+    log_keep_probability = bit_rate >= 1.0 ? -INFINITY : std::log1p(-bit_rate);
+    workspaces.resize(omp_get_max_threads());
+    for (RepairWorkspace &workspace : workspaces)
+    {
+        workspace.induced_degree.resize(g.get_number_of_vertices());
+        workspace.candidates = VertexSet(g.get_number_of_vertices());
+    }
+}
+
+// Replace the default stopping criteria (just the generation budget) for the next runs
+void GeneticAlgorithm::set_stopping_criteria(const StoppingCriteria &criteria)
+{
+    // A generation takes far longer than reading the clock, so check the time limit after every one
+    StoppingCriteria per_generation = criteria;
+    per_generation.clock_interval = 1;
+    stopping = StoppingPolicy(per_generation);
+}
+
+const StoppingPolicy &GeneticAlgorithm::get_stopping_policy() const
+{
+    return stopping;
+}
+
+const SolverProfile &GeneticAlgorithm::get_profile() const
+{
+    return profile;
+}
 
 // Run the genetic algorithm and return the best clique found as a vector of vertex indices
 std::vector<int> GeneticAlgorithm::run()
 {
+    stopping.start();
+    profile.reset(workspaces.size());
+    // Every buffer the generation loop touches is allocated here, once
     int num_vertices = graph.get_number_of_vertices();
-    population.clear();
-    population.resize(population_size);
-    #pragma omp parallel for
+    population.assign(2 * population_size, VertexSet(num_vertices));
+    next_population.assign(2 * population_size, VertexSet(num_vertices));
+    fitnesses.assign(2 * population_size, 0);
+    next_fitnesses.assign(2 * population_size, 0);
+    selected.assign(2 * population_size, 0);
+#pragma omp parallel for schedule(dynamic)
     for (int i = 0; i < population_size; ++i)
     {
-        population[i] = random_individual(num_vertices);
+        PROFILE_PHASE(profile, Phase::Initialisation);
+        CounterRng rng(seed, stream_id(INITIAL_POPULATION_STEP, i));
+        random_individual(population[i], rng);
+        fitnesses[i] = fitness(population[i]);
     }
 
+    stopping.improve(*std::max_element(fitnesses.begin(), fitnesses.begin() + population_size));
+
     // Evolution loop
-    for (int generation = 0; generation < generations; ++generation)
+    for (int generation = 0; !stopping.should_stop(); ++generation)
     {
+        current_generation = generation;
         if (generation % 10 == 0)
             std::cout << "Generation " << generation << std::endl;
         next_generation();
+        stopping.improve(*std::max_element(fitnesses.begin(), fitnesses.begin() + population_size));
     }
-    std::bitset<NUM_MAX_VERTICES> best_individual;
-    int best_fitness = 0;
 
+    int best_idx = 0;
     for (int i = 0; i < population_size; i++)
     {
-        int f = fitness(population[i]);
-        if (f >= best_fitness)
+        if (fitnesses[i] >= fitnesses[best_idx])
         {
-            best_fitness = f;
-            best_individual = population[i];
+            best_idx = i;
         }
     }
 
-    std::vector<int> clique;
-    for (int i = 0; i < graph.get_number_of_vertices(); ++i)
-    {
-        if (best_individual[i])
-            clique.push_back(i);
-    }
-
-    return clique;
+    return population[best_idx].to_vector();
 }
@@ -1,16 +1,33 @@
 #ifndef GENETIC_ALGORITHM_H
 #define GENETIC_ALGORITHM_H
 
-#include <bitset>
+#include <algorithm>
 #include <vector>
 #include <random>
 #include "../graph/graph.h"
+#include "../common/random.h"
+#include "../common/stopping.h"
+#include "../common/profile.h"
 #include <cassert>
-#include <set>
-#include <map>
 #include <chrono>
 #include <omp.h>
 
+// Scratch buffers for repair_clique, one per thread, allocated once per run
+struct RepairWorkspace
+{
+    std::vector<int> induced_degree; // |N(v) & individual| for every v in the individual
+    VertexSet candidates;            // Vertices adjacent to every member of the clique
+};
+
+// Crossover operators; all of them work on whole 64-bit words
+enum class CrossoverOperator
+{
+    SinglePoint, // Swap the tails after a random point
+    TwoPoint,    // Swap the segment between two random points
+    Uniform,     // Take each bit from either parent with probability 1/2
+    CliqueAware  // Children are the intersection and the union of the parents; repair turns both into cliques
+};
+
 class GeneticAlgorithm
 {
 private:
@@ -18,40 +35,68 @@ private:
     int population_size;
     double crossover_probability;
     double mutation_probability;
-    int generations;
+    CrossoverOperator crossover_operator;
+    double log_keep_probability; // log(1 - per-bit mutation rate), for geometric skipping
 
-    std::vector<std::bitset<NUM_MAX_VERTICES>> population; // Population of bitsets
-    std::random_device rd;                                 // Random device for random number generation
-    std::mt19937 gen;                                      // Mersenne Twister random number generator
-    std::uniform_real_distribution<double> dist;
-    // Generate a random individual represented by a bitset
-    std::bitset<NUM_MAX_VERTICES> random_individual(int num_vertices);
+    // Double-buffered populations: slots [0, population_size) of `population` hold the
+    // parents and [population_size, 2 * population_size) their offspring; selection copies
+    // the winners into `next_population`, and the two buffers swap roles every generation
+    std::vector<VertexSet> population;
+    std::vector<VertexSet> next_population;
+    std::vector<int> fitnesses; // Cached fitness of each slot of `population`
+    std::vector<int> next_fitnesses;
+    std::vector<char> selected;
+    std::uint64_t seed;    // Every random stream of a run derives from this seed
+    int current_generation;
+    std::vector<RepairWorkspace> workspaces; // Indexed by OpenMP thread number
+    StoppingPolicy stopping; // Counts generations; defaults to the `gens` of the constructor
+    SolverProfile profile;
+    // Fill `ind` with a random individual and repair it into a clique
+    void random_individual(VertexSet &ind, CounterRng &rng);
 
-    // Fitness function: return clique size if valid, otherwise 0
-    int fitness(const std::bitset<NUM_MAX_VERTICES> &ind);
+    // Fitness function: the clique size; computed once per individual and cached in `fitnesses`
+    int fitness(const VertexSet &ind);
 
     // Check if the selected vertices form a clique in the graph
-    bool is_clique(const std::vector<int> &vertices);
+    bool is_clique(const VertexSet &vertices);
 
+    // Crossover with the configured operator, writing two children into preallocated sets
+    void crossover(const VertexSet &parent1, const VertexSet &parent2, VertexSet &child1, VertexSet &child2, CounterRng &rng);
 
-    // Single-point crossover to generate a child individual
-    // Single-point crossover to generate a child individual
-    std::pair<std::bitset<NUM_MAX_VERTICES>, std::bitset<NUM_MAX_VERTICES>> crossover(const std::bitset<NUM_MAX_VERTICES> &parent1, const std::bitset<NUM_MAX_VERTICES> &parent2);
+    // Children take bits [begin, end) from the other parent and the rest from their own
+    void exchange_segment(const VertexSet &parent1, const VertexSet &parent2, VertexSet &child1, VertexSet &child2, int begin, int end);
 
-    // Mutation: Flip random bits in the individual based on mutation rate
-    void mutate(std::bitset<NUM_MAX_VERTICES> &individual);
+    // Mutation: every bit flips independently with probability mutation_probability
+    void mutate(VertexSet &individual, CounterRng &rng);
 
-    void generate_offspring(std::vector<std::bitset<NUM_MAX_VERTICES>> &prev_population);
+    void generate_offspring();
 
-    void select_new_population(std::vector<std::bitset<NUM_MAX_VERTICES>> &parents_and_offspring);
+    void select_new_population();
     // Generate the next generation of individuals
     void next_generation();
 
-    void repair_clique(std::bitset<NUM_MAX_VERTICES> &individual);
+    // Turn an individual into a maximal clique: drop min induced degree vertices, then extend greedily
+    void repair_clique(VertexSet &individual);
 
 public:
-    // Constructor: Initializes the genetic algorithm with the given graph, population size, mutation rate, and number of generations
-    GeneticAlgorithm(const Graph &g, int pop_size, double crossover_probability, double mutation_probability, int gens);
+    // Bumped whenever an operator change makes results of earlier versions incomparable; the
+    // tuning checkpoints only reuse runs of the current version. 1 is the original GA, 2 the
+    // greedy-extension repair with word-level crossover and a per-bit mutation rate of pm / n,
+    // 3 flips each bit with probability pm.
+    static constexpr int VERSION = 3;
+
+    // Constructor: Initializes the genetic algorithm with the given graph, population size, crossover and mutation rates,
+    // number of generations and crossover operator. mutation_probability is the chance of each bit of a child to flip.
+    // Runs with the same seed and thread count produce the same cliques.
+    GeneticAlgorithm(const Graph &g, int pop_size, double crossover_probability, double mutation_probability, int gens,
+                     CrossoverOperator crossover_operator = CrossoverOperator::SinglePoint,
+                     std::uint64_t seed = std::random_device{}());
+
+    // Replace the default stopping criteria (just the generation budget) for the next runs
+    void set_stopping_criteria(const StoppingCriteria &criteria);
+    const StoppingPolicy &get_stopping_policy() const;
+    // Counters and phase times of the last run; all zero unless built with CLIQUE_PROFILE
+    const SolverProfile &get_profile() const;
 
     // Run the genetic algorithm and return the best clique found as a vector of vertex indices
     std::vector<int> run();
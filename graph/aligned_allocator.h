@@ -0,0 +1,41 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+#include <cstddef>
+#include <new>
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// Allocator that places every block on an Alignment-byte boundary, so that
+// containers of packed words start on a cache line
+template <typename T, std::size_t Alignment = CACHE_LINE_SIZE>
+struct AlignedAllocator
+{
+  using value_type = T;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n)
+  {
+    return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T *p, std::size_t) noexcept
+  {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept { return true; }
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept { return false; }
+};
+
+#endif
@@ -1,30 +1,67 @@
 #include "graph.h"
 #include <cassert>
-#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <numeric>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Below this edge density a packed row holds more words than the vertex has
+// neighbours, and the matrix outgrows the CSR arrays
+constexpr double DENSE_MIN_DENSITY = 1.0 / WORD_BITS;
+// Never allocate a packed matrix larger than this, whatever the density
+constexpr std::size_t DENSE_MAX_MATRIX_BYTES = std::size_t(1) << 30;
 
 Graph::Graph()
 {
+  this->requested_storage = GraphStorage::Automatic;
   this->set_number_of_vertices(0);
   this->set_number_of_edges(0);
 }
 
-Graph::Graph(int number_of_vertices)
+Graph::Graph(int number_of_vertices, GraphStorage storage)
 {
+  this->requested_storage = storage;
   this->set_number_of_vertices(number_of_vertices);
   this->set_number_of_edges(0);
 }
 
+Graph Graph::from_edges(int number_of_vertices, const std::vector<std::pair<int, int>> &edges, GraphStorage storage)
+{
+  Graph graph(number_of_vertices, storage);
+  graph.pending_arcs.reserve(2 * edges.size());
+  for (auto const &[u, v] : edges)
+  {
+    graph.add_edge(u, v);
+  }
+  graph.build_csr();
+  graph.relabel(graph.compute_ordering(VertexOrdering::Degree));
+  graph.build_adjacency_matrix();
+  return graph;
+}
+
 void Graph::set_number_of_vertices(int number_of_vertices)
 {
   assert(number_of_vertices >= 0 and "Number of vertices must be non-negative");
-  assert(number_of_vertices <= NUM_MAX_VERTICES and "Number of vertices must be less than NUM_MAX_VERTICES");
   this->number_of_vertices = number_of_vertices;
-  this->adjacency_list.resize(number_of_vertices);
-  this->adjacency_matrix.resize(number_of_vertices, std::vector<bool>(number_of_vertices, false));
+  this->dense = false;
+  this->pending_arcs.clear();
+  this->neighbour_offsets.assign(number_of_vertices + 1, 0);
+  this->degrees.assign(number_of_vertices, 0);
+  this->neighbours.clear();
+  this->number_of_words = (number_of_vertices + WORD_BITS - 1) / WORD_BITS;
+  this->row_stride = 0;
+  this->adjacency_matrix.clear();
   this->index2label.resize(number_of_vertices);
   this->label2index.resize(number_of_vertices + 1);
+  for (int v = 0; v < number_of_vertices; ++v)
+  {
+    this->index2label[v] = v + 1;
+    this->label2index[v + 1] = v;
+  }
 }
 
 void Graph::set_number_of_edges(int number_of_edges)
@@ -34,16 +71,12 @@ void Graph::set_number_of_edges(int number_of_edges)
 
 void Graph::add_edge(int u, int v, bool directed)
 {
-  assert(this->number_of_vertices >= u and this->number_of_vertices >= v and
+  assert(this->number_of_vertices > u and this->number_of_vertices > v and
          "Can't add edge if there are not enough vertices");
-  if (directed)
-  {
-    this->adjacency_list.at(u).push_back(v);
-  }
-  else
+  this->pending_arcs.emplace_back(u, v);
+  if (!directed)
   {
-    this->adjacency_list.at(u).push_back(v);
-    this->adjacency_list.at(v).push_back(u);
+    this->pending_arcs.emplace_back(v, u);
   }
 }
 
@@ -52,8 +85,9 @@ void Graph::print_to_stdout()
   for (int i = 0; i < this->number_of_vertices; i++)
   {
     std::cout << "Vértice: " << this->index2label.at(i) << "; vizinhos: ";
-    for (auto &neighbour : this->adjacency_list.at(i))
+    for (std::size_t k = this->neighbour_offsets[i]; k < this->neighbour_offsets[i] + this->degrees[i]; ++k)
     {
+      int neighbour = this->neighbours[k];
       std::cout << this->index2label.at(neighbour) << " ";
     }
     std::cout << std::endl;
@@ -69,114 +103,381 @@ void Graph::print_to_stdout()
 
 int Graph::get_number_of_vertices() const { return this->number_of_vertices; }
 
-bool Graph::is_edge(int u, int v) const
+bool Graph::is_edge_sparse(int u, int v) const
 {
-  return this->adjacency_matrix.at(u).at(v);
+  // Search the shorter of the two sorted rows
+  if (this->degrees[u] > this->degrees[v])
+    std::swap(u, v);
+  const int *row = this->neighbours.data() + this->neighbour_offsets[u];
+  return std::binary_search(row, row + this->degrees[u], v);
 }
 
-void Graph::read_edge_list(const std::string &filename)
+int Graph::count_neighbours_in(int v, const word_t *set) const
 {
-  std::ifstream input(filename);
-  std::string line;
-  int number_of_vertices = 0, number_of_edges;
-  while (std::getline(input, line))
+  int count = 0;
+  if (this->dense)
   {
-    if (line.at(0) == 'c')
-      continue;
-    if (line.at(0) == 'p')
+    const word_t *row = this->get_row(v);
+    for (int w = 0; w < this->number_of_words; ++w)
     {
-      // parse number of vertices
-      char c;
-      std::string col;
-      std::istringstream iss(line);
-      iss >> c >> col >> number_of_vertices >> number_of_edges;
-      this->set_number_of_vertices(number_of_vertices);
-      continue;
+      count += __builtin_popcountll(row[w] & set[w]);
     }
-    if (line.at(0) == 'e')
+    return count;
+  }
+  const int *row = this->neighbours.data() + this->neighbour_offsets[v];
+  for (int k = 0; k < this->degrees[v]; ++k)
+  {
+    count += (set[row[k] / WORD_BITS] >> (row[k] % WORD_BITS)) & 1;
+  }
+  return count;
+}
+
+void Graph::intersect_with_neighbours(int v, word_t *set) const
+{
+  if (this->dense)
+  {
+    const word_t *row = this->get_row(v);
+    for (int w = 0; w < this->number_of_words; ++w)
     {
-      char c;
-      int u, v;
-      std::istringstream iss(line);
-      iss >> c >> u >> v;
-      assert(u <= number_of_vertices and v <= number_of_vertices and "Vertex out of bounds");
-      u--;
-      v--;
-      this->add_edge(u, v);
-      continue;
+      set[w] &= row[w];
     }
+    return;
   }
-  sort_adjacency_list();
-  build_adjacency_matrix();
-  input.close();
+  // Merge the set bits, in increasing order, against the sorted row
+  const int *it = this->neighbours.data() + this->neighbour_offsets[v];
+  const int *end = it + this->degrees[v];
+  for (int w = 0; w < this->number_of_words; ++w)
+  {
+    for (word_t bits = set[w]; bits; bits &= bits - 1)
+    {
+      int u = w * WORD_BITS + __builtin_ctzll(bits);
+      while (it != end and *it < u)
+        ++it;
+      if (it == end or *it != u)
+        set[w] &= ~(word_t(1) << (u % WORD_BITS));
+    }
+  }
+}
+
+bool Graph::is_clique(const word_t *set) const
+{
+  if (!this->dense)
+  {
+    int size = 0;
+    for (int w = 0; w < this->number_of_words; ++w)
+    {
+      size += __builtin_popcountll(set[w]);
+    }
+    for (int w = 0; w < this->number_of_words; ++w)
+    {
+      for (word_t bits = set[w]; bits; bits &= bits - 1)
+      {
+        int v = w * WORD_BITS + __builtin_ctzll(bits);
+        if (this->degrees[v] < size - 1 or this->count_neighbours_in(v, set) != size - 1)
+          return false;
+      }
+    }
+    return true;
+  }
+  for (int w = 0; w < this->number_of_words; ++w)
+  {
+    for (word_t bits = set[w]; bits; bits &= bits - 1)
+    {
+      int bit = __builtin_ctzll(bits);
+      const word_t *row = this->get_row(w * WORD_BITS + bit);
+      // Only pairs (v, u) with u > v need checking, the matrix is symmetric
+      if (set[w] & ~row[w] & ~((word_t(2) << bit) - 1))
+        return false;
+      for (int x = w + 1; x < this->number_of_words; ++x)
+      {
+        if (set[x] & ~row[x])
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+static const char *skip_blanks(const char *p, const char *end)
+{
+  while (p < end and (*p == ' ' or *p == '\t'))
+    ++p;
+  return p;
+}
+
+static const char *skip_token(const char *p, const char *end)
+{
+  while (p < end and *p != ' ' and *p != '\t' and *p != '\n' and *p != '\r')
+    ++p;
+  return p;
 }
 
-void Graph::sort_adjacency_list()
+static const char *parse_int(const char *p, const char *end, long long &value)
 {
-  std::vector<std::pair<std::vector<int>, int>> indexed_list;
-  for (size_t i = 0; i < this->adjacency_list.size(); ++i)
+  p = skip_blanks(p, end);
+  value = 0;
+  while (p < end and *p >= '0' and *p <= '9')
   {
-    indexed_list.emplace_back(this->adjacency_list[i], i);
+    value = value * 10 + (*p - '0');
+    ++p;
   }
+  return p;
+}
 
-  std::sort(indexed_list.begin(), indexed_list.end(),
-            [](const std::pair<std::vector<int>, int> &a, const std::pair<std::vector<int>, int> &b)
-            {
-              return a.first.size() > b.first.size();
-            });
+bool Graph::read_edge_list(const std::string &filename, GraphStorage storage, VertexOrdering ordering)
+{
+  auto start = std::chrono::steady_clock::now();
+  this->requested_storage = storage;
+  this->load_statistics = LoadStatistics();
+  this->set_number_of_vertices(0);
 
-  for (size_t i = 0; i < indexed_list.size(); ++i)
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
   {
-    this->index2label[i] = indexed_list[i].second + 1;
-    this->label2index[indexed_list[i].second + 1] = i;
+    std::cerr << "Erro ao abrir o arquivo do grafo: " << filename << std::endl;
+    return false;
   }
-  for (auto const& [neighbours, label_minus_1] : indexed_list)
+  struct stat file_status;
+  if (fstat(fd, &file_status) != 0)
   {
-    this->adjacency_list[this->label2index[label_minus_1 + 1]].clear();
-    for (auto const neighbour : neighbours)
+    std::cerr << "Erro ao ler o tamanho do arquivo do grafo: " << filename << std::endl;
+    close(fd);
+    return false;
+  }
+  std::size_t size = file_status.st_size;
+  const char *data = nullptr;
+  if (size > 0)
+  {
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED)
     {
-      this->adjacency_list[this->label2index[label_minus_1 + 1]].push_back(this->label2index[neighbour + 1]);
+      data = static_cast<const char *>(mapping);
+      madvise(mapping, size, MADV_SEQUENTIAL);
     }
   }
+  close(fd);
+  if (data == nullptr and size > 0)
+  {
+    std::cerr << "Erro ao mapear o arquivo do grafo: " << filename << std::endl;
+    return false;
+  }
+
+  const char *end = data + size;
+  long long number_of_vertices = 0;
+  for (const char *p = data; p < end;)
+  {
+    const char *line_end = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (line_end == nullptr)
+      line_end = end;
+    if (*p == 'p')
+    {
+      // "p <format> <vertices> <edges>"
+      long long number_of_edges;
+      const char *q = skip_token(skip_blanks(skip_token(p, line_end), line_end), line_end);
+      q = parse_int(q, line_end, number_of_vertices);
+      parse_int(q, line_end, number_of_edges);
+      this->set_number_of_vertices(number_of_vertices);
+      this->pending_arcs.reserve(2 * number_of_edges);
+    }
+    else if (*p == 'e')
+    {
+      long long u, v;
+      const char *q = parse_int(p + 1, line_end, u);
+      parse_int(q, line_end, v);
+      assert(u >= 1 and v >= 1 and u <= number_of_vertices and v <= number_of_vertices and "Vertex out of bounds");
+      this->load_statistics.edges_read++;
+      if (u == v)
+        this->load_statistics.self_loops++;
+      else
+        this->add_edge(u - 1, v - 1);
+    }
+    p = line_end + 1;
+  }
+  if (data != nullptr)
+    munmap(const_cast<char *>(data), size);
+
+  build_csr();
+  // Other orderings start from the degree order, so they come out the same as through the cache
+  relabel(compute_ordering(VertexOrdering::Degree));
+  if (ordering != VertexOrdering::Degree)
+    relabel(compute_ordering(ordering));
+  build_adjacency_matrix();
+
+  this->load_statistics.bytes = size;
+  this->load_statistics.duplicate_edges = this->load_statistics.edges_read - this->load_statistics.self_loops - this->number_of_edges;
+  this->load_statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return true;
+}
+
+void Graph::print_load_statistics(std::ostream &out) const
+{
+  const LoadStatistics &stats = this->load_statistics;
+  if (stats.from_cache)
+  {
+    out << "Grafo carregado do cache: " << this->number_of_vertices << " vertices, " << this->number_of_edges
+        << " arestas em " << stats.seconds << " s; " << stats.bytes / 1e6 / std::max(stats.seconds, 1e-9) << " MB/s" << std::endl;
+    return;
+  }
+  out << "Grafo carregado: " << this->number_of_vertices << " vertices, " << this->number_of_edges << " arestas ("
+      << stats.self_loops << " lacos e " << stats.duplicate_edges << " arestas repetidas descartadas) em "
+      << stats.seconds << " s; " << stats.bytes / 1e6 / std::max(stats.seconds, 1e-9) << " MB/s, "
+      << stats.edges_read / std::max(stats.seconds, 1e-9) << " arestas/s" << std::endl;
+}
+
+void Graph::build_csr()
+{
+  std::fill(this->degrees.begin(), this->degrees.end(), 0);
+  for (auto const &[u, v] : this->pending_arcs)
+  {
+    this->degrees[u]++;
+  }
+  this->neighbour_offsets[0] = 0;
+  for (int v = 0; v < this->number_of_vertices; ++v)
+  {
+    this->neighbour_offsets[v + 1] = this->neighbour_offsets[v] + this->degrees[v];
+  }
+  this->neighbours.resize(this->pending_arcs.size());
+  std::vector<std::size_t> cursor(this->neighbour_offsets.begin(), this->neighbour_offsets.end() - 1);
+  for (auto const &[u, v] : this->pending_arcs)
+  {
+    this->neighbours[cursor[u]++] = v;
+  }
+  this->pending_arcs.clear();
+  this->pending_arcs.shrink_to_fit();
+
+  // Sort every row and drop repeated edges and self-loops, compacting in place
+  std::size_t write = 0;
+  for (int v = 0; v < this->number_of_vertices; ++v)
+  {
+    auto begin = this->neighbours.begin() + this->neighbour_offsets[v];
+    auto end = this->neighbours.begin() + this->neighbour_offsets[v + 1];
+    std::sort(begin, end);
+    end = std::unique(begin, end);
+    end = std::remove(begin, end, v);
+    this->neighbour_offsets[v] = write;
+    this->degrees[v] = end - begin;
+    write = std::copy(begin, end, this->neighbours.begin() + write) - this->neighbours.begin();
+  }
+  this->neighbour_offsets[this->number_of_vertices] = write;
+  this->neighbours.resize(write);
+  this->neighbours.shrink_to_fit();
+  this->set_number_of_edges(write / 2);
 }
 
 void Graph::build_adjacency_matrix()
 {
-  for (size_t i = 0; i < this->adjacency_list.size(); ++i)
+  int row_stride = (this->number_of_words + WORDS_PER_CACHE_LINE - 1) / WORDS_PER_CACHE_LINE * WORDS_PER_CACHE_LINE;
+  std::size_t matrix_bytes = (std::size_t)this->number_of_vertices * row_stride * sizeof(word_t);
+  double density = this->number_of_vertices > 1
+                       ? 2.0 * this->number_of_edges / ((double)this->number_of_vertices * (this->number_of_vertices - 1))
+                       : 1.0;
+  switch (this->requested_storage)
   {
-    for (auto &neighbour : this->adjacency_list[i])
+  case GraphStorage::Dense:
+    this->dense = true;
+    break;
+  case GraphStorage::Sparse:
+    this->dense = false;
+    break;
+  case GraphStorage::Automatic:
+    this->dense = density >= DENSE_MIN_DENSITY and matrix_bytes <= DENSE_MAX_MATRIX_BYTES;
+    break;
+  }
+  if (!this->dense)
+  {
+    this->row_stride = 0;
+    this->adjacency_matrix.clear();
+    this->adjacency_matrix.shrink_to_fit();
+    return;
+  }
+
+  this->row_stride = row_stride;
+  this->adjacency_matrix.assign((std::size_t)this->number_of_vertices * row_stride, 0);
+  for (int i = 0; i < this->number_of_vertices; ++i)
+  {
+    word_t *row = this->adjacency_matrix.data() + (std::size_t)i * this->row_stride;
+    for (std::size_t k = this->neighbour_offsets[i]; k < this->neighbour_offsets[i] + this->degrees[i]; ++k)
     {
-      this->adjacency_matrix[i][neighbour] = true;
+      row[this->neighbours[k] / WORD_BITS] |= word_t(1) << (this->neighbours[k] % WORD_BITS);
     }
   }
 }
 
-Graph Graph::get_subgraph(std::vector<int> vertices) const
+InducedSubgraph Graph::get_induced_subgraph(const std::vector<int> &vertices, bool reorder) const
 {
-  Graph subgraph(vertices.size());
-  for (size_t i = 0; i < vertices.size(); ++i)
+  int k = vertices.size();
+  VertexSet mask(this->number_of_vertices);
+  for (int v : vertices)
+  {
+    mask.set(v);
+  }
+  std::vector<int> order(k);
+  std::iota(order.begin(), order.end(), 0);
+  if (reorder)
   {
-    for (size_t j = i + 1; j < vertices.size(); ++j)
+    std::vector<int> induced_degree(k);
+    for (int i = 0; i < k; ++i)
     {
-      if (this->is_edge(vertices[i], vertices[j]))
-      {
-        subgraph.add_edge(i, j);
-      }
+      induced_degree[i] = this->count_neighbours_in(vertices[i], mask);
     }
+    std::stable_sort(order.begin(), order.end(),
+                     [&induced_degree](int a, int b)
+                     {
+                       return induced_degree[a] > induced_degree[b];
+                     });
+  }
+
+  InducedSubgraph result;
+  Graph &subgraph = result.graph;
+  subgraph.requested_storage = this->requested_storage;
+  subgraph.set_number_of_vertices(k);
+  result.to_parent.resize(k);
+  std::vector<int> to_local(this->number_of_vertices, -1);
+  for (int i = 0; i < k; ++i)
+  {
+    result.to_parent[i] = vertices[order[i]];
+    to_local[result.to_parent[i]] = i;
+    subgraph.index2label[i] = i + 1;
+    subgraph.label2index[i + 1] = i;
   }
-  subgraph.sort_adjacency_list();
+
+  // Parent rows are scanned in increasing parent order, so a row only needs sorting when
+  // the local numbering does not follow it
+  bool increasing = std::is_sorted(result.to_parent.begin(), result.to_parent.end());
+  for (int i = 0; i < k; ++i)
+  {
+    std::size_t begin = subgraph.neighbours.size();
+    this->for_each_neighbour_in(result.to_parent[i], mask.data(),
+                                [&subgraph, &to_local](int u)
+                                { subgraph.neighbours.push_back(to_local[u]); });
+    if (!increasing)
+      std::sort(subgraph.neighbours.begin() + begin, subgraph.neighbours.end());
+    subgraph.neighbour_offsets[i + 1] = subgraph.neighbours.size();
+    subgraph.degrees[i] = subgraph.neighbours.size() - begin;
+  }
+  subgraph.set_number_of_edges(subgraph.neighbours.size() / 2);
   subgraph.build_adjacency_matrix();
-  return subgraph;
+  return result;
 }
 
 void Graph::remove_vertex(int vertex)
 {
-  for (auto &neighbour : this->adjacency_list[vertex])
+  const int *row = this->neighbours.data() + this->neighbour_offsets[vertex];
+  for (int k = 0; k < this->degrees[vertex]; ++k)
   {
-    this->adjacency_list[neighbour].erase(std::remove(this->adjacency_list[neighbour].begin(), this->adjacency_list[neighbour].end(), vertex), this->adjacency_list[neighbour].end());
-    this->adjacency_matrix[vertex].erase(std::remove(this->adjacency_matrix[vertex].begin(), this->adjacency_matrix[vertex].end(), true), this->adjacency_matrix[vertex].end());
+    int neighbour = row[k];
+    auto begin = this->neighbours.begin() + this->neighbour_offsets[neighbour];
+    auto end = begin + this->degrees[neighbour];
+    auto position = std::lower_bound(begin, end, vertex);
+    std::copy(position + 1, end, position);
+    this->degrees[neighbour]--;
+    if (this->dense)
+      this->adjacency_matrix[(std::size_t)neighbour * this->row_stride + vertex / WORD_BITS] &= ~(word_t(1) << (vertex % WORD_BITS));
   }
-  this->adjacency_list[vertex].clear();
+  if (this->dense)
+    std::fill_n(this->adjacency_matrix.begin() + (std::size_t)vertex * this->row_stride, this->row_stride, 0);
+  this->set_number_of_edges(this->number_of_edges - this->degrees[vertex]);
+  this->degrees[vertex] = 0;
 }
 
 int Graph::get_vertex_with_lowest_degree()
@@ -185,9 +486,9 @@ int Graph::get_vertex_with_lowest_degree()
   int vertex = -1;
   for (int i = 0; i < this->get_number_of_vertices(); ++i)
   {
-    if ((int) this->adjacency_list[i].size() < min_degree)
+    if (this->degrees[i] < min_degree)
     {
-      min_degree = this->adjacency_list[i].size();
+      min_degree = this->degrees[i];
       vertex = i;
     }
   }
@@ -196,5 +497,11 @@ int Graph::get_vertex_with_lowest_degree()
 
 std::vector<std::vector<int>> Graph::get_adjacency_list() const
 {
-  return this->adjacency_list;
-}
\ No newline at end of file
+  std::vector<std::vector<int>> adjacency_list(this->number_of_vertices);
+  for (int v = 0; v < this->number_of_vertices; ++v)
+  {
+    auto begin = this->neighbours.begin() + this->neighbour_offsets[v];
+    adjacency_list[v].assign(begin, begin + this->degrees[v]);
+  }
+  return adjacency_list;
+}
@@ -1,41 +1,200 @@
 #ifndef GRAPH_H
 #define GRAPH_H
+#include <ostream>
+#include <span>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include "aligned_allocator.h"
+#include "vertex_set.h"
 
 using adj_list_t = std::vector<std::vector<int>>;
 
+// How adjacency is stored: the CSR arrays always exist, the packed matrix only when dense
+enum class GraphStorage
+{
+  Automatic,
+  Dense,
+  Sparse
+};
+
+// How vertices are numbered once a graph is built; every ordering is O(n + m) and breaks ties
+// by the previous vertex number, so the numbering is deterministic
+enum class VertexOrdering
+{
+  Degree,             // Decreasing degree
+  Degeneracy,         // Decreasing core number, then decreasing degree
+  MinWidth,           // Smallest-last (Matula-Beck): peel minimum-degree vertices, the last one peeled comes first
+  ReverseCuthillMcKee // Breadth-first by increasing degree, reversed; neighbours get nearby rows
+};
+
+// Counters filled in by read_edge_list
+struct LoadStatistics
+{
+  double seconds = 0.0;
+  std::size_t bytes = 0;
+  long long edges_read = 0;
+  long long self_loops = 0;
+  long long duplicate_edges = 0;
+  bool from_cache = false;
+};
+
+struct InducedSubgraph;
+
 class Graph
 {
 
 private:
   int number_of_vertices;
   int number_of_edges;
+  GraphStorage requested_storage;
+  bool dense;
+  LoadStatistics load_statistics;
 
   std::vector<int> index2label;
   std::vector<int> label2index;
-  std::vector<std::vector<int>> adjacency_list;
-  std::vector<std::vector<bool>> adjacency_matrix;
+  // Arcs added through add_edge, consumed when the CSR arrays are built
+  std::vector<std::pair<int, int>> pending_arcs;
+  // CSR adjacency: N(v) is neighbours[neighbour_offsets[v] .. neighbour_offsets[v] + degrees[v]), sorted
+  std::vector<std::size_t> neighbour_offsets;
+  std::vector<int> degrees;
+  std::vector<int> neighbours;
+  // Row v holds N(v) packed into 64-bit words; rows are padded to whole cache lines
+  int number_of_words;
+  int row_stride;
+  std::vector<word_t, AlignedAllocator<word_t>> adjacency_matrix;
   void add_edge(int u, int v, bool directed = false);
   void set_number_of_vertices(int number_of_vertices);
   void set_number_of_edges(int number_of_edges);
-  void sort_adjacency_list();
+  // Renumber vertices so that vertex i becomes order[i]; rows stay sorted
+  void relabel(const std::vector<int> &order);
+  // Vertices in the order minimum-degree peeling removes them, and their core numbers
+  void peel(std::vector<int> &removal_order, std::vector<int> &core) const;
+  void build_csr();
   void build_adjacency_matrix();
+  bool is_edge_sparse(int u, int v) const;
+  bool load_binary(const std::string &path, long long source_mtime, long long source_size, GraphStorage storage);
+  bool save_binary(const std::string &path, long long source_mtime, long long source_size) const;
 
 public:
   Graph();
-  Graph(int number_of_vertices);
+  Graph(int number_of_vertices, GraphStorage storage = GraphStorage::Automatic);
+  // Graph on vertices 0 .. number_of_vertices - 1 with the given undirected edges. Like every
+  // graph it is relabeled by decreasing degree; get_label(v) - 1 is v's number in `edges`.
+  static Graph from_edges(int number_of_vertices, const std::vector<std::pair<int, int>> &edges,
+                          GraphStorage storage = GraphStorage::Automatic);
   int get_number_of_vertices() const;
-  bool is_edge(int u, int v) const;
-  void read_edge_list(const std::string &filename);
-  Graph get_subgraph(std::vector<int> vertices) const;
+  int get_number_of_edges() const { return this->number_of_edges; }
+  bool is_dense() const { return this->dense; }
+  bool is_edge(int u, int v) const
+  {
+    if (this->dense)
+      return (this->adjacency_matrix[(std::size_t)u * this->row_stride + (v / WORD_BITS)] >> (v % WORD_BITS)) & 1;
+    return this->is_edge_sparse(u, v);
+  }
+
+  int get_degree(int v) const { return this->degrees[v]; }
+  // Vertex label in the input file (1-based)
+  int get_label(int v) const { return this->index2label[v]; }
+  // Vertex v is vertex get_permutation()[v] of the input file, counting from 0
+  std::vector<int> get_permutation() const;
+  // Core number of every vertex (Batagelj-Zaversnik bucket peeling)
+  std::vector<int> get_core_numbers() const;
+  // order[i] is the vertex that `ordering` puts at position i; the graph is left as it is
+  std::vector<int> compute_ordering(VertexOrdering ordering) const;
+  // Renumber the vertices by `ordering`; returns the order applied (see compute_ordering)
+  std::vector<int> reorder(VertexOrdering ordering);
+  // Sorted neighbours of v, viewed in place
+  std::span<const int> get_neighbours(int v) const
+  {
+    return std::span<const int>(this->neighbours.data() + this->neighbour_offsets[v], this->degrees[v]);
+  }
+
+  // Number of words a vertex set needs to cover every vertex of the graph
+  int get_number_of_words() const { return this->number_of_words; }
+  // Packed row of N(v); only available when is_dense()
+  const word_t *get_row(int v) const { return this->adjacency_matrix.data() + (std::size_t)v * this->row_stride; }
+  // |N(v) & set|
+  int count_neighbours_in(int v, const word_t *set) const;
+  // set &= N(v)
+  void intersect_with_neighbours(int v, word_t *set) const;
+  // True if every pair of vertices in the packed set is adjacent
+  bool is_clique(const word_t *set) const;
+  // Call f(u) for every u in N(v) & set, in increasing order
+  template <typename F>
+  void for_each_neighbour_in(int v, const word_t *set, F f) const
+  {
+    if (this->dense)
+    {
+      const word_t *row = this->get_row(v);
+      for (int w = 0; w < this->number_of_words; ++w)
+      {
+        for (word_t bits = row[w] & set[w]; bits; bits &= bits - 1)
+          f(w * WORD_BITS + __builtin_ctzll(bits));
+      }
+      return;
+    }
+    for (int u : this->get_neighbours(v))
+    {
+      if ((set[u / WORD_BITS] >> (u % WORD_BITS)) & 1)
+        f(u);
+    }
+  }
+  // Call f(u) for every u != v that is not adjacent to v, in increasing order
+  template <typename F>
+  void for_each_non_neighbour(int v, F f) const
+  {
+    if (this->dense)
+    {
+      const word_t *row = this->get_row(v);
+      for (int w = 0; w < this->number_of_words; ++w)
+      {
+        word_t bits = ~row[w];
+        if (w == v / WORD_BITS)
+          bits &= ~(word_t(1) << (v % WORD_BITS));
+        if (w == this->number_of_words - 1 and this->number_of_vertices % WORD_BITS != 0)
+          bits &= (word_t(1) << (this->number_of_vertices % WORD_BITS)) - 1;
+        for (; bits; bits &= bits - 1)
+          f(w * WORD_BITS + __builtin_ctzll(bits));
+      }
+      return;
+    }
+    auto neighbour = this->get_neighbours(v).begin();
+    auto end = this->get_neighbours(v).end();
+    for (int u = 0; u < this->number_of_vertices; ++u)
+    {
+      if (neighbour != end and *neighbour == u)
+        ++neighbour;
+      else if (u != v)
+        f(u);
+    }
+  }
+  int count_neighbours_in(int v, const VertexSet &set) const { return this->count_neighbours_in(v, set.data()); }
+  void intersect_with_neighbours(int v, VertexSet &set) const { this->intersect_with_neighbours(v, set.data()); }
+  bool is_clique(const VertexSet &set) const { return this->is_clique(set.data()); }
+  // False if the file could not be opened or mapped; the graph is then left empty
+  bool read_edge_list(const std::string &filename, GraphStorage storage = GraphStorage::Automatic,
+                      VertexOrdering ordering = VertexOrdering::Degree);
+  // Like read_edge_list, but goes through the binary cache "<filename>.bin" (see graph_cache.cpp)
+  bool load(const std::string &filename, GraphStorage storage = GraphStorage::Automatic,
+            VertexOrdering ordering = VertexOrdering::Degree);
+  const LoadStatistics &get_load_statistics() const { return this->load_statistics; }
+  void print_load_statistics(std::ostream &out) const;
+  // Subgraph induced by `vertices` (distinct), built by masking rows in O(k * n / 64) when dense
+  // and O(sum of degrees) when sparse. Vertex i of the result is vertices[i], or with reorder the
+  // subgraph is relabeled by decreasing degree (ties keep their order in `vertices`).
+  InducedSubgraph get_induced_subgraph(const std::vector<int> &vertices, bool reorder = false) const;
   int get_vertex_with_lowest_degree();
   void remove_vertex(int vertex);
   void print_to_stdout();
+  // Copies every row; solvers should use get_degree and get_neighbours instead
   std::vector<std::vector<int>> get_adjacency_list() const;
 };
 
-constexpr int NUM_MAX_VERTICES = 4000;
+struct InducedSubgraph
+{
+  Graph graph;
+  std::vector<int> to_parent; // Vertex v of graph is vertex to_parent[v] of the parent
+};
 
 #endif
\ No newline at end of file
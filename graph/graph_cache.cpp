@@ -0,0 +1,222 @@
+#include "graph.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary cache of an already relabeled graph, in native byte order:
+//   CacheHeader, then each of the following sections on a cache-line boundary
+//   index2label[n], label2index[n + 1], neighbour_offsets[n + 1], degrees[n],
+//   neighbours[number_of_arcs] and, for dense graphs, adjacency_matrix[n * row_stride]
+// A load maps the file and copies each section into the graph's own arrays with one memcpy:
+// Graph owns and rewrites them (reorder, relabel, copies that outlive the file), so it does
+// not keep views into the mapping. What the cache saves is the parse, the degree sort and
+// building the CSR arrays and the matrix.
+namespace
+{
+  constexpr char CACHE_MAGIC[8] = {'H', 'M', 'G', 'R', 'A', 'P', 'H', '\0'};
+  constexpr std::uint32_t CACHE_VERSION = 2;
+
+  struct CacheHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dense;
+    std::int64_t source_mtime;
+    std::int64_t source_size;
+    std::int64_t number_of_vertices;
+    std::int64_t number_of_edges;
+    std::int64_t number_of_arcs;
+    std::int64_t row_stride;
+    std::uint64_t checksum; // FNV-1a over every field above
+  };
+
+  struct CacheLayout
+  {
+    std::size_t index2label;
+    std::size_t label2index;
+    std::size_t neighbour_offsets;
+    std::size_t degrees;
+    std::size_t neighbours;
+    std::size_t adjacency_matrix;
+    std::size_t total;
+  };
+
+  std::uint64_t header_checksum(const CacheHeader &header)
+  {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&header);
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < offsetof(CacheHeader, checksum); ++i)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  std::size_t align_up(std::size_t offset)
+  {
+    return (offset + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+  }
+
+  CacheLayout cache_layout(const CacheHeader &header)
+  {
+    std::size_t n = header.number_of_vertices;
+    CacheLayout layout;
+    layout.index2label = align_up(sizeof(CacheHeader));
+    layout.label2index = align_up(layout.index2label + n * sizeof(int));
+    layout.neighbour_offsets = align_up(layout.label2index + (n + 1) * sizeof(int));
+    layout.degrees = align_up(layout.neighbour_offsets + (n + 1) * sizeof(std::size_t));
+    layout.neighbours = align_up(layout.degrees + n * sizeof(int));
+    layout.adjacency_matrix = align_up(layout.neighbours + header.number_of_arcs * sizeof(int));
+    layout.total = layout.adjacency_matrix + (header.dense ? n * header.row_stride * sizeof(word_t) : 0);
+    return layout;
+  }
+
+  void write_section(std::ofstream &out, std::size_t offset, const void *data, std::size_t bytes)
+  {
+    static const char padding[CACHE_LINE_SIZE] = {};
+    out.write(padding, offset - out.tellp());
+    out.write(static_cast<const char *>(data), bytes);
+  }
+}
+
+bool Graph::load_binary(const std::string &path, long long source_mtime, long long source_size, GraphStorage storage)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat file_status;
+  if (fstat(fd, &file_status) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  std::size_t size = file_status.st_size;
+  void *mapping = size >= sizeof(CacheHeader) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (mapping == MAP_FAILED)
+    return false;
+  const char *data = static_cast<const char *>(mapping);
+
+  CacheHeader header;
+  std::memcpy(&header, data, sizeof(CacheHeader));
+  bool storage_matches = storage == GraphStorage::Automatic or
+                         (storage == GraphStorage::Dense) == (header.dense != 0);
+  if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 or header.version != CACHE_VERSION or
+      header.checksum != header_checksum(header) or header.source_mtime != source_mtime or
+      header.source_size != source_size or cache_layout(header).total != size or !storage_matches)
+  {
+    munmap(mapping, size);
+    return false;
+  }
+
+  CacheLayout layout = cache_layout(header);
+  int n = header.number_of_vertices;
+  this->requested_storage = storage;
+  this->set_number_of_vertices(n);
+  this->set_number_of_edges(header.number_of_edges);
+  const int *index2label = reinterpret_cast<const int *>(data + layout.index2label);
+  const int *label2index = reinterpret_cast<const int *>(data + layout.label2index);
+  const std::size_t *neighbour_offsets = reinterpret_cast<const std::size_t *>(data + layout.neighbour_offsets);
+  const int *degrees = reinterpret_cast<const int *>(data + layout.degrees);
+  const int *neighbours = reinterpret_cast<const int *>(data + layout.neighbours);
+  this->index2label.assign(index2label, index2label + n);
+  this->label2index.assign(label2index, label2index + n + 1);
+  this->neighbour_offsets.assign(neighbour_offsets, neighbour_offsets + n + 1);
+  this->degrees.assign(degrees, degrees + n);
+  this->neighbours.assign(neighbours, neighbours + header.number_of_arcs);
+  this->dense = header.dense != 0;
+  if (this->dense)
+  {
+    const word_t *matrix = reinterpret_cast<const word_t *>(data + layout.adjacency_matrix);
+    this->row_stride = header.row_stride;
+    this->adjacency_matrix.assign(matrix, matrix + (std::size_t)n * this->row_stride);
+  }
+  munmap(mapping, size);
+  return true;
+}
+
+bool Graph::save_binary(const std::string &path, long long source_mtime, long long source_size) const
+{
+  CacheHeader header;
+  std::memset(&header, 0, sizeof(CacheHeader));
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.dense = this->dense;
+  header.source_mtime = source_mtime;
+  header.source_size = source_size;
+  header.number_of_vertices = this->number_of_vertices;
+  header.number_of_edges = this->number_of_edges;
+  header.number_of_arcs = this->neighbours.size();
+  header.row_stride = this->dense ? this->row_stride : 0;
+  header.checksum = header_checksum(header);
+  CacheLayout layout = cache_layout(header);
+
+  // Write to a private temporary file and rename it, so concurrent loads never see a partial cache
+  std::string temporary_path = path + ".tmp" + std::to_string(getpid()) + "." +
+                               std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+    return false;
+  std::size_t n = this->number_of_vertices;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(CacheHeader));
+  write_section(out, layout.index2label, this->index2label.data(), n * sizeof(int));
+  write_section(out, layout.label2index, this->label2index.data(), (n + 1) * sizeof(int));
+  write_section(out, layout.neighbour_offsets, this->neighbour_offsets.data(), (n + 1) * sizeof(std::size_t));
+  write_section(out, layout.degrees, this->degrees.data(), n * sizeof(int));
+  write_section(out, layout.neighbours, this->neighbours.data(), this->neighbours.size() * sizeof(int));
+  if (this->dense)
+    write_section(out, layout.adjacency_matrix, this->adjacency_matrix.data(), n * this->row_stride * sizeof(word_t));
+  out.close();
+  if (!out or std::rename(temporary_path.c_str(), path.c_str()) != 0)
+  {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// The cache always holds the graph in degree order; other orderings are applied after loading
+bool Graph::load(const std::string &filename, GraphStorage storage, VertexOrdering ordering)
+{
+  auto start = std::chrono::steady_clock::now();
+  struct stat source;
+  if (stat(filename.c_str(), &source) != 0)
+  {
+    return this->read_edge_list(filename, storage, ordering);
+  }
+  long long source_mtime = source.st_mtim.tv_sec * 1000000000LL + source.st_mtim.tv_nsec;
+  std::string cache_path = filename + ".bin";
+  if (this->load_binary(cache_path, source_mtime, source.st_size, storage))
+  {
+    this->load_statistics = LoadStatistics();
+    this->load_statistics.from_cache = true;
+    this->load_statistics.edges_read = this->number_of_edges;
+    struct stat cache;
+    if (stat(cache_path.c_str(), &cache) == 0)
+      this->load_statistics.bytes = cache.st_size;
+    this->load_statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  else
+  {
+    // A file that could not be read must not be cached as an empty graph
+    if (!this->read_edge_list(filename, storage))
+      return false;
+    if (!this->save_binary(cache_path, source_mtime, source.st_size))
+    {
+      std::cerr << "Aviso: nao foi possivel gravar o cache " << cache_path << std::endl;
+    }
+  }
+  if (ordering != VertexOrdering::Degree)
+    this->reorder(ordering);
+  return true;
+}
@@ -0,0 +1,238 @@
+#include "graph.h"
+
+// Vertex orderings and relabeling. Every ordering is built from counting sorts and bucket
+// peeling over the CSR arrays, in O(n + m), and breaks ties by the current vertex number.
+namespace
+{
+  // Stable counting sort of `vertices` by key, largest key first
+  std::vector<int> sort_by_decreasing(const std::vector<int> &vertices, const std::vector<int> &key)
+  {
+    int max_key = 0;
+    for (int v : vertices)
+    {
+      max_key = std::max(max_key, key[v]);
+    }
+    std::vector<int> start(max_key + 2, 0);
+    for (int v : vertices)
+    {
+      start[max_key - key[v] + 1]++;
+    }
+    for (int k = 1; k <= max_key + 1; ++k)
+    {
+      start[k] += start[k - 1];
+    }
+    std::vector<int> sorted(vertices.size());
+    for (int v : vertices)
+    {
+      sorted[start[max_key - key[v]]++] = v;
+    }
+    return sorted;
+  }
+
+  // Stable counting sort of `vertices` by key, smallest key first
+  std::vector<int> sort_by_increasing(const std::vector<int> &vertices, const std::vector<int> &key)
+  {
+    int max_key = 0;
+    for (int v : vertices)
+    {
+      max_key = std::max(max_key, key[v]);
+    }
+    std::vector<int> start(max_key + 2, 0);
+    for (int v : vertices)
+    {
+      start[key[v] + 1]++;
+    }
+    for (int k = 1; k <= max_key + 1; ++k)
+    {
+      start[k] += start[k - 1];
+    }
+    std::vector<int> sorted(vertices.size());
+    for (int v : vertices)
+    {
+      sorted[start[key[v]]++] = v;
+    }
+    return sorted;
+  }
+}
+
+std::vector<int> Graph::get_permutation() const
+{
+  std::vector<int> permutation(this->number_of_vertices);
+  for (int v = 0; v < this->number_of_vertices; ++v)
+  {
+    permutation[v] = this->index2label[v] - 1;
+  }
+  return permutation;
+}
+
+void Graph::peel(std::vector<int> &removal_order, std::vector<int> &core) const
+{
+  int n = this->number_of_vertices;
+  core.assign(this->degrees.begin(), this->degrees.end());
+  int max_degree = 0;
+  for (int v = 0; v < n; ++v)
+  {
+    max_degree = std::max(max_degree, core[v]);
+  }
+  // removal_order holds the vertices sorted by current degree; bin[d] is where degree d starts
+  std::vector<int> bin(max_degree + 1, 0);
+  for (int v = 0; v < n; ++v)
+  {
+    bin[core[v]]++;
+  }
+  for (int d = 0, start = 0; d <= max_degree; ++d)
+  {
+    int count = bin[d];
+    bin[d] = start;
+    start += count;
+  }
+  std::vector<int> position(n);
+  removal_order.resize(n);
+  for (int v = 0; v < n; ++v)
+  {
+    position[v] = bin[core[v]]++;
+    removal_order[position[v]] = v;
+  }
+  for (int d = max_degree; d > 0; --d)
+  {
+    bin[d] = bin[d - 1];
+  }
+  bin[0] = 0;
+
+  for (int i = 0; i < n; ++i)
+  {
+    int v = removal_order[i];
+    for (int u : this->get_neighbours(v))
+    {
+      if (core[u] > core[v])
+      {
+        // Move u to the front of its bin, then shrink the bin past it
+        int first = removal_order[bin[core[u]]];
+        if (first != u)
+        {
+          std::swap(removal_order[position[u]], removal_order[bin[core[u]]]);
+          std::swap(position[u], position[first]);
+        }
+        bin[core[u]]++;
+        core[u]--;
+      }
+    }
+  }
+}
+
+std::vector<int> Graph::get_core_numbers() const
+{
+  std::vector<int> removal_order, core;
+  this->peel(removal_order, core);
+  return core;
+}
+
+std::vector<int> Graph::compute_ordering(VertexOrdering ordering) const
+{
+  int n = this->number_of_vertices;
+  std::vector<int> identity(n);
+  for (int v = 0; v < n; ++v)
+  {
+    identity[v] = v;
+  }
+  switch (ordering)
+  {
+  case VertexOrdering::Degree:
+    return sort_by_decreasing(identity, this->degrees);
+  case VertexOrdering::Degeneracy:
+    return sort_by_decreasing(sort_by_decreasing(identity, this->degrees), this->get_core_numbers());
+  case VertexOrdering::MinWidth:
+  {
+    std::vector<int> removal_order, core;
+    this->peel(removal_order, core);
+    return std::vector<int>(removal_order.rbegin(), removal_order.rend());
+  }
+  case VertexOrdering::ReverseCuthillMcKee:
+  {
+    std::vector<int> by_degree = sort_by_increasing(identity, this->degrees);
+    // Rows listing neighbours by increasing degree: walk the vertices in that order and
+    // append each to the rows of its neighbours
+    std::vector<int> rows(this->neighbours.size());
+    std::vector<std::size_t> cursor(this->neighbour_offsets.begin(), this->neighbour_offsets.end() - 1);
+    for (int u : by_degree)
+    {
+      for (int x : this->get_neighbours(u))
+      {
+        rows[cursor[x]++] = u;
+      }
+    }
+    // Breadth-first search from the lowest-degree vertex left in each component
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+    for (int start : by_degree)
+    {
+      if (visited[start])
+        continue;
+      visited[start] = 1;
+      order.push_back(start);
+      for (std::size_t head = order.size() - 1; head < order.size(); ++head)
+      {
+        int v = order[head];
+        for (std::size_t k = this->neighbour_offsets[v]; k < this->neighbour_offsets[v] + this->degrees[v]; ++k)
+        {
+          if (!visited[rows[k]])
+          {
+            visited[rows[k]] = 1;
+            order.push_back(rows[k]);
+          }
+        }
+      }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+  }
+  }
+  return identity;
+}
+
+void Graph::relabel(const std::vector<int> &order)
+{
+  int n = this->number_of_vertices;
+  std::vector<int> new_index(n);
+  for (int i = 0; i < n; ++i)
+  {
+    new_index[order[i]] = i;
+  }
+  std::vector<int> degrees(n);
+  std::vector<std::size_t> neighbour_offsets(n + 1, 0);
+  for (int i = 0; i < n; ++i)
+  {
+    degrees[i] = this->degrees[order[i]];
+    neighbour_offsets[i + 1] = neighbour_offsets[i] + degrees[i];
+  }
+  // Appending u to the rows of its neighbours in increasing u leaves every row sorted
+  std::vector<int> neighbours(this->neighbours.size());
+  std::vector<std::size_t> cursor(neighbour_offsets.begin(), neighbour_offsets.end() - 1);
+  for (int u = 0; u < n; ++u)
+  {
+    for (int x : this->get_neighbours(order[u]))
+    {
+      neighbours[cursor[new_index[x]]++] = u;
+    }
+  }
+  std::vector<int> index2label(n);
+  for (int i = 0; i < n; ++i)
+  {
+    index2label[i] = this->index2label[order[i]];
+    this->label2index[index2label[i]] = i;
+  }
+  this->index2label.swap(index2label);
+  this->degrees.swap(degrees);
+  this->neighbour_offsets.swap(neighbour_offsets);
+  this->neighbours.swap(neighbours);
+}
+
+std::vector<int> Graph::reorder(VertexOrdering ordering)
+{
+  std::vector<int> order = this->compute_ordering(ordering);
+  this->relabel(order);
+  if (this->dense)
+    this->build_adjacency_matrix();
+  return order;
+}
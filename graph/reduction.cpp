@@ -0,0 +1,229 @@
+#include "reduction.h"
+#include <algorithm>
+#include <numeric>
+
+// The greedy lower bound tries at most this many start vertices
+constexpr int MAX_GREEDY_STARTS = 256;
+
+std::vector<int> ReductionResult::to_parent_vertices(const std::vector<int> &clique) const
+{
+  std::vector<int> vertices;
+  vertices.reserve(clique.size());
+  for (int v : clique)
+  {
+    vertices.push_back(this->to_parent[v]);
+  }
+  return vertices;
+}
+
+std::vector<int> ReductionResult::to_labels(const std::vector<int> &clique) const
+{
+  std::vector<int> labels;
+  labels.reserve(clique.size());
+  for (int v : clique)
+  {
+    labels.push_back(this->labels[v]);
+  }
+  std::sort(labels.begin(), labels.end());
+  return labels;
+}
+
+std::vector<int> greedy_clique(const Graph &graph, const std::vector<int> &core)
+{
+  int n = graph.get_number_of_vertices();
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&core](int a, int b)
+                   { return core[a] > core[b]; });
+
+  std::vector<int> best, clique, candidates, next;
+  for (int i = 0; i < std::min(n, MAX_GREEDY_STARTS); ++i)
+  {
+    int v = order[i];
+    // A vertex of core number k lies in no clique of more than k + 1 vertices
+    if (core[v] + 1 <= (int)best.size())
+      break;
+    clique.assign(1, v);
+    candidates.clear();
+    for (int u : graph.get_neighbours(v))
+    {
+      if (core[u] >= (int)best.size())
+        candidates.push_back(u);
+    }
+    while (!candidates.empty())
+    {
+      int u = *std::max_element(candidates.begin(), candidates.end(), [&core](int a, int b)
+                                { return core[a] < core[b]; });
+      clique.push_back(u);
+      auto neighbours = graph.get_neighbours(u);
+      next.clear();
+      std::set_intersection(candidates.begin(), candidates.end(), neighbours.begin(), neighbours.end(),
+                            std::back_inserter(next));
+      candidates.swap(next);
+    }
+    if (clique.size() > best.size())
+      best = clique;
+  }
+  return best;
+}
+
+namespace
+{
+  void erase_sorted(std::vector<int> &row, int v)
+  {
+    auto position = std::lower_bound(row.begin(), row.end(), v);
+    if (position != row.end() and *position == v)
+      row.erase(position);
+  }
+
+  int count_common(const std::vector<int> &a, const std::vector<int> &b)
+  {
+    int count = 0;
+    for (auto i = a.begin(), j = b.begin(); i != a.end() and j != b.end();)
+    {
+      if (*i < *j)
+        ++i;
+      else if (*j < *i)
+        ++j;
+      else
+      {
+        ++count;
+        ++i;
+        ++j;
+      }
+    }
+    return count;
+  }
+}
+
+ReductionResult reduce_graph(const Graph &graph, bool triangle_pruning)
+{
+  int n = graph.get_number_of_vertices();
+  ReductionResult result;
+  std::vector<int> core = graph.get_core_numbers();
+  result.greedy_clique = greedy_clique(graph, core);
+  result.lower_bound = result.greedy_clique.size();
+  int min_degree = result.lower_bound - 1;
+
+  // Core peeling: a clique of LB vertices only uses vertices of core number LB - 1 or more
+  std::vector<int> kept, to_local(n, -1);
+  for (int v = 0; v < n; ++v)
+  {
+    if (core[v] >= min_degree)
+    {
+      to_local[v] = kept.size();
+      kept.push_back(v);
+    }
+  }
+  result.removed_by_core = n - kept.size();
+
+  // Rows stay sorted because to_local is increasing
+  int k = kept.size();
+  std::vector<std::vector<int>> adjacency(k);
+  for (int i = 0; i < k; ++i)
+  {
+    for (int u : graph.get_neighbours(kept[i]))
+    {
+      if (to_local[u] >= 0)
+        adjacency[i].push_back(to_local[u]);
+    }
+  }
+
+  std::vector<char> alive(k, 1);
+  if (triangle_pruning)
+  {
+    // Both ends of an edge of an LB-clique share its other LB - 2 vertices
+    int min_common = result.lower_bound - 2;
+    std::vector<std::pair<int, int>> doomed;
+    std::vector<int> queue;
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      doomed.clear();
+      for (int u = 0; u < k; ++u)
+      {
+        for (int v : adjacency[u])
+        {
+          if (v > u and count_common(adjacency[u], adjacency[v]) < min_common)
+            doomed.emplace_back(u, v);
+        }
+      }
+      for (auto const &[u, v] : doomed)
+      {
+        erase_sorted(adjacency[u], v);
+        erase_sorted(adjacency[v], u);
+      }
+      result.removed_edges += doomed.size();
+
+      queue.clear();
+      for (int u = 0; u < k; ++u)
+      {
+        if (alive[u] and (int)adjacency[u].size() < min_degree)
+        {
+          alive[u] = 0;
+          queue.push_back(u);
+        }
+      }
+      while (!queue.empty())
+      {
+        int u = queue.back();
+        queue.pop_back();
+        result.removed_by_triangles++;
+        for (int w : adjacency[u])
+        {
+          erase_sorted(adjacency[w], u);
+          if (alive[w] and (int)adjacency[w].size() < min_degree)
+          {
+            alive[w] = 0;
+            queue.push_back(w);
+          }
+        }
+        adjacency[u].clear();
+        changed = true;
+      }
+      changed = changed or !doomed.empty();
+    }
+  }
+
+  std::vector<int> survivors, to_survivor(k, -1);
+  for (int i = 0; i < k; ++i)
+  {
+    if (alive[i])
+    {
+      to_survivor[i] = survivors.size();
+      survivors.push_back(kept[i]);
+    }
+  }
+  if (result.removed_edges == 0)
+  {
+    // Only vertices were removed: what is left is an induced subgraph
+    InducedSubgraph induced = graph.get_induced_subgraph(survivors, true);
+    result.graph = std::move(induced.graph);
+    result.to_parent = std::move(induced.to_parent);
+  }
+  else
+  {
+    std::vector<std::pair<int, int>> edges;
+    for (int u = 0; u < k; ++u)
+    {
+      for (int v : adjacency[u])
+      {
+        if (v > u)
+          edges.emplace_back(to_survivor[u], to_survivor[v]);
+      }
+    }
+    result.graph = Graph::from_edges(survivors.size(), edges);
+    result.to_parent.resize(survivors.size());
+    for (int v = 0; v < (int)survivors.size(); ++v)
+    {
+      result.to_parent[v] = survivors[result.graph.get_label(v) - 1];
+    }
+  }
+  result.labels.resize(result.to_parent.size());
+  for (int v = 0; v < (int)result.to_parent.size(); ++v)
+  {
+    result.labels[v] = graph.get_label(result.to_parent[v]);
+  }
+  return result;
+}
@@ -0,0 +1,34 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+#include <vector>
+#include "graph.h"
+
+// A graph shrunk before the search: vertex v of `graph` is vertex to_parent[v] of the input.
+// Every clique of the input with at least lower_bound vertices is still a clique here, so a
+// maximum clique of `graph`, mapped back, is a maximum clique of the input.
+struct ReductionResult
+{
+  Graph graph;
+  std::vector<int> to_parent;
+  std::vector<int> labels;        // Label in the input file (1-based) of every vertex of `graph`
+  std::vector<int> greedy_clique; // The clique behind lower_bound, in input vertex numbers
+  int lower_bound = 0;
+  int removed_by_core = 0;       // Vertices whose core number is below lower_bound - 1
+  int removed_by_triangles = 0;  // Vertices left without enough degree once edges were pruned
+  long long removed_edges = 0;   // Edges in fewer than lower_bound - 2 triangles
+
+  // Translate a clique of `graph` into input vertex numbers
+  std::vector<int> to_parent_vertices(const std::vector<int> &clique) const;
+  // Same, as sorted labels of the input file; this is how results are reported
+  std::vector<int> to_labels(const std::vector<int> &clique) const;
+};
+
+// A maximal clique built greedily from the most promising start vertices; cheap lower bound
+std::vector<int> greedy_clique(const Graph &graph, const std::vector<int> &core);
+
+// Take a greedy lower bound LB, peel every vertex of core number below LB - 1 and, with
+// triangle_pruning, repeatedly drop edges in fewer than LB - 2 triangles and the vertices
+// whose degree falls below LB - 1. Any clique of at least LB vertices survives.
+ReductionResult reduce_graph(const Graph &graph, bool triangle_pruning = false);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef VERTEX_LIST_H
+#define VERTEX_LIST_H
+#include <vector>
+
+// Unordered list of vertices with O(1) insert, erase and membership test.
+// Storage for every vertex of the graph is allocated up front.
+class VertexList
+{
+private:
+  std::vector<int> items;
+  std::vector<int> position; // Index of v in items, or -1
+  int count;
+
+public:
+  VertexList() : count(0) {}
+  explicit VertexList(int number_of_vertices) : items(number_of_vertices), position(number_of_vertices, -1), count(0) {}
+
+  int size() const { return this->count; }
+  bool empty() const { return this->count == 0; }
+  int operator[](int i) const { return this->items[i]; }
+  const int *begin() const { return this->items.data(); }
+  const int *end() const { return this->items.data() + this->count; }
+  bool contains(int v) const { return this->position[v] >= 0; }
+
+  void insert(int v)
+  {
+    this->position[v] = this->count;
+    this->items[this->count++] = v;
+  }
+
+  void erase(int v)
+  {
+    int last = this->items[--this->count];
+    this->items[this->position[v]] = last;
+    this->position[last] = this->position[v];
+    this->position[v] = -1;
+  }
+
+  void clear()
+  {
+    for (int i = 0; i < this->count; ++i)
+      this->position[this->items[i]] = -1;
+    this->count = 0;
+  }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef VERTEX_SET_H
+#define VERTEX_SET_H
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "aligned_allocator.h"
+
+using word_t = std::uint64_t;
+constexpr int WORD_BITS = 64;
+constexpr int WORDS_PER_CACHE_LINE = CACHE_LINE_SIZE / sizeof(word_t);
+
+// Set of vertices packed into 64-bit words, sized at runtime to the graph.
+// Bits at positions >= get_number_of_vertices() are always zero.
+class VertexSet
+{
+private:
+  int number_of_vertices;
+  std::vector<word_t, AlignedAllocator<word_t>> words;
+
+public:
+  VertexSet() : number_of_vertices(0) {}
+  explicit VertexSet(int number_of_vertices)
+      : number_of_vertices(number_of_vertices), words((number_of_vertices + WORD_BITS - 1) / WORD_BITS, 0) {}
+
+  int get_number_of_vertices() const { return this->number_of_vertices; }
+  int get_number_of_words() const { return (int)this->words.size(); }
+  word_t *data() { return this->words.data(); }
+  const word_t *data() const { return this->words.data(); }
+
+  bool test(int v) const { return (this->words[v / WORD_BITS] >> (v % WORD_BITS)) & 1; }
+  bool operator[](int v) const { return this->test(v); }
+  void set(int v) { this->words[v / WORD_BITS] |= word_t(1) << (v % WORD_BITS); }
+  void set(int v, bool value)
+  {
+    if (value)
+      this->set(v);
+    else
+      this->reset(v);
+  }
+  void reset(int v) { this->words[v / WORD_BITS] &= ~(word_t(1) << (v % WORD_BITS)); }
+  void flip(int v) { this->words[v / WORD_BITS] ^= word_t(1) << (v % WORD_BITS); }
+  void clear() { std::fill(this->words.begin(), this->words.end(), 0); }
+  // Add every vertex of the graph
+  void fill()
+  {
+    std::fill(this->words.begin(), this->words.end(), ~word_t(0));
+    this->mask_tail();
+  }
+
+  // Zero the unused high bits of the last word after writing whole words
+  void mask_tail()
+  {
+    if (this->number_of_vertices % WORD_BITS != 0)
+      this->words.back() &= (word_t(1) << (this->number_of_vertices % WORD_BITS)) - 1;
+  }
+
+  int count() const
+  {
+    int count = 0;
+    for (word_t w : this->words)
+      count += __builtin_popcountll(w);
+    return count;
+  }
+
+  bool any() const
+  {
+    return std::any_of(this->words.begin(), this->words.end(), [](word_t w)
+                       { return w != 0; });
+  }
+
+  // Call f(v) for every vertex v in the set, in increasing order
+  template <typename F>
+  void for_each(F f) const
+  {
+    for (int w = 0; w < (int)this->words.size(); ++w)
+    {
+      for (word_t bits = this->words[w]; bits; bits &= bits - 1)
+      {
+        f(w * WORD_BITS + __builtin_ctzll(bits));
+      }
+    }
+  }
+
+  std::vector<int> to_vector() const
+  {
+    std::vector<int> vertices;
+    vertices.reserve(this->count());
+    this->for_each([&vertices](int v)
+                   { vertices.push_back(v); });
+    return vertices;
+  }
+
+  bool operator==(const VertexSet &other) const { return this->words == other.words; }
+  bool operator!=(const VertexSet &other) const { return this->words != other.words; }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <omp.h>
+#include "portfolio.h"
+#include "../ga/ga.h"
+#include "../sa/SimulatedAnnealing.h"
+#include "../ts/tabusearch.h"
+#include "../bnb/branch_and_bound.h"
+#include "../common/random.h"
+
+namespace
+{
+    // Iteration budget of one run, as in test()
+    constexpr int GA_GENERATIONS = 100;
+    constexpr int TABU_ITERATIONS = 100000;
+    constexpr int TABU_TENURE = 10;
+}
+
+Portfolio::Portfolio(const Graph &graph, const StoppingCriteria &criteria, std::uint64_t seed)
+    : graph(graph), criteria(criteria), seed(seed), found_by(PortfolioSolver::None), runs(0), optimal(false)
+{
+    // Each run gets the portfolio's own incumbent
+    this->criteria.incumbent = nullptr;
+}
+
+void Portfolio::add_member(PortfolioSolver kind)
+{
+    members.push_back(kind);
+}
+
+void Portfolio::add_default_members(int threads)
+{
+    const PortfolioSolver heuristics[] = {PortfolioSolver::Tabu, PortfolioSolver::Annealing, PortfolioSolver::Genetic};
+    int first = 0;
+    if (threads >= 2)
+    {
+        add_member(PortfolioSolver::Exact);
+        first = 1;
+    }
+    for (int i = first; i < threads; ++i)
+        add_member(heuristics[(i - first) % 3]);
+}
+
+bool Portfolio::should_stop() const
+{
+    return incumbent->stop_requested() || incumbent->get_size() >= criteria.target ||
+           stopping.elapsed() >= criteria.time_limit;
+}
+
+// The race's criteria for one run: what is left of the time limit, the shared incumbent and,
+// unless max_iterations is set, the solver's usual budget, so heuristics restart from the shared best
+StoppingCriteria Portfolio::member_criteria(long long default_iterations) const
+{
+    StoppingCriteria member = criteria;
+    member.incumbent = incumbent.get();
+    member.trace = nullptr;
+    member.time_limit = criteria.time_limit - stopping.elapsed();
+    if (member.max_iterations == StoppingCriteria().max_iterations)
+        member.max_iterations = default_iterations;
+    return member;
+}
+
+std::vector<int> Portfolio::run_once(PortfolioSolver kind, std::uint64_t run_seed)
+{
+    switch (kind)
+    {
+    case PortfolioSolver::Genetic:
+    {
+        GeneticAlgorithm ga(graph, 100, 0.9, 0.1, GA_GENERATIONS, CrossoverOperator::SinglePoint, run_seed);
+        ga.set_stopping_criteria(member_criteria(GA_GENERATIONS));
+        return ga.run();
+    }
+    case PortfolioSolver::Annealing:
+    {
+        // Start at the size of the shared best, so the first size tried is one larger
+        std::vector<int> start = incumbent->get_clique();
+        std::unique_ptr<SimulatedAnnealing> sa =
+            start.empty() ? std::make_unique<SimulatedAnnealing>(100.0, 0.001, 0.9995, graph, 1, run_seed)
+                          : std::make_unique<SimulatedAnnealing>(100.0, 0.001, 0.9995, graph, (int)start.size(), start, run_seed);
+        // The cooling schedule ends the run on its own
+        sa->setStoppingCriteria(member_criteria(StoppingCriteria().max_iterations));
+        return sa->run();
+    }
+    case PortfolioSolver::Tabu:
+    {
+        TabuSearch ts(graph, incumbent->get_clique(), TABU_TENURE, TABU_ITERATIONS, run_seed);
+        ts.setStoppingCriteria(member_criteria(TABU_ITERATIONS));
+        ts.run();
+        return ts.getBestSolution();
+    }
+    case PortfolioSolver::Exact:
+    {
+        BranchAndBound bnb(graph, incumbent->get_clique());
+        bnb.set_threads(1);
+        bnb.set_stopping_criteria(member_criteria(StoppingCriteria().max_iterations));
+        ExactResult result = bnb.run();
+        // The search pruned against the shared best, so its bound covers the other members' cliques
+        if (result.upper_bound <= incumbent->get_size())
+        {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            optimal = true;
+            incumbent->request_stop();
+        }
+        return result.clique;
+    }
+    case PortfolioSolver::None:
+        break;
+    }
+    return {};
+}
+
+void Portfolio::publish(PortfolioSolver kind, const std::vector<int> &clique)
+{
+    std::lock_guard<std::mutex> lock(result_mutex);
+    if (incumbent->offer(clique))
+    {
+        found_by = kind;
+        stopping.improve(clique.size());
+    }
+}
+
+void Portfolio::run_member(int index)
+{
+    // One core per member: the genetic algorithm's OpenMP loops would oversubscribe the others
+    omp_set_num_threads(1);
+    PortfolioSolver kind = members[index];
+    for (int round = 0; !should_stop(); ++round)
+    {
+        {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            // The race's iterations are solver runs started; the trace records them with each new best
+            stopping.set_iterations(++runs);
+        }
+        CounterRng rng(seed, stream_id(round, index));
+        publish(kind, run_once(kind, rng()));
+        // The exact solver only ends on a limit or a proof; without a time limit every member runs once
+        if (kind == PortfolioSolver::Exact || !std::isfinite(criteria.time_limit))
+            break;
+    }
+}
+
+PortfolioResult Portfolio::run()
+{
+    incumbent = std::make_unique<SharedIncumbent>();
+    stopping = StoppingPolicy(criteria);
+    stopping.start();
+    found_by = PortfolioSolver::None;
+    runs = 0;
+    optimal = false;
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < (int)members.size(); ++i)
+        pool.emplace_back(&Portfolio::run_member, this, i);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    PortfolioResult result;
+    result.clique = incumbent->get_clique();
+    result.optimal = optimal;
+    result.seconds = stopping.elapsed();
+    result.time_to_best = stopping.get_time_to_best();
+    result.time_to_target = stopping.get_time_to_target();
+    result.found_by = found_by;
+    result.runs = runs;
+    return result;
+}
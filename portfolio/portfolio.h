@@ -0,0 +1,74 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "../graph/graph.h"
+#include "../common/incumbent.h"
+#include "../common/stopping.h"
+
+enum class PortfolioSolver
+{
+    Genetic,
+    Annealing,
+    Tabu,
+    Exact, // Branch and bound on one thread; when it finishes, the shared best is optimal
+    None   // found_by of a race in which no member published a clique
+};
+
+struct PortfolioResult
+{
+    std::vector<int> clique;
+    bool optimal;          // The exact member proved no larger clique exists
+    double seconds;
+    double time_to_best;   // Seconds until `clique` was published (at the end of the run that found it)
+    double time_to_target; // Same for the first clique reaching the target, or -1
+    PortfolioSolver found_by;
+    int runs;              // Solver runs started by all members together
+};
+
+// Races independently seeded solvers on one graph, one thread per member. They share a
+// SharedIncumbent: every improvement raises its size, so the branch and bound prunes against
+// the global best, simulated annealing and tabu search start from the best clique published,
+// and every member stops as soon as the shared best reaches the target. Heuristic runs get the
+// solver's usual iteration budget; a member whose run ends while time is left starts another
+// one with a fresh seed. Without a time limit every member runs once.
+class Portfolio
+{
+private:
+    const Graph &graph;
+    StoppingCriteria criteria;
+    std::uint64_t seed;
+    std::vector<PortfolioSolver> members;
+
+    std::unique_ptr<SharedIncumbent> incumbent;
+    std::mutex result_mutex; // Guards stopping.improve, found_by, runs and optimal
+    StoppingPolicy stopping; // Times the whole race; its improve() records time to best and to target
+    PortfolioSolver found_by;
+    int runs;
+    bool optimal;
+
+    bool should_stop() const;
+    StoppingCriteria member_criteria(long long default_iterations) const;
+    std::vector<int> run_once(PortfolioSolver kind, std::uint64_t run_seed);
+    void publish(PortfolioSolver kind, const std::vector<int> &clique);
+    void run_member(int index);
+
+public:
+    // criteria applies to the race as a whole: time_limit and target end it, max_iterations
+    // and stall_iterations apply to every single solver run, and the trace records the shared
+    // best as members publish it
+    Portfolio(const Graph &graph, const StoppingCriteria &criteria, std::uint64_t seed = std::random_device{}());
+
+    void add_member(PortfolioSolver kind);
+    // `threads` members: one exact solver (given at least two threads), the rest cycling
+    // through tabu search, simulated annealing and the genetic algorithm
+    void add_default_members(int threads);
+
+    PortfolioResult run();
+};
+
+#endif // PORTFOLIO_H
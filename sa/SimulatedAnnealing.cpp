@@ -2,17 +2,21 @@
 
 
 
-SimulatedAnnealing::SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, Graph graph, int cliqueSize, vector<int> perm)
+SimulatedAnnealing::SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, const Graph &graph, int cliqueSize, vector<int> perm,
+                                       std::uint64_t seed)
     : initialTemperature(initialTemp), endTemperature(endTemp), coolingCoefficient(coolingCoeff), currentTemperature(initialTemp),
-      graph(graph), m(cliqueSize), n(graph.get_number_of_vertices()), permutation(perm), last_clique(perm), rng(random_device{}()) {
+      graph(graph), m(cliqueSize), n(graph.get_number_of_vertices()), permutation(perm), last_clique(perm), rng(seed),
+      temperatureReset(TemperatureReset::Keep), reheatFactor(2.0), profile("sa") {
     
     initialize(perm);
     
 }
 
-SimulatedAnnealing::SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, Graph graph, int cliqueSize)
+SimulatedAnnealing::SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, const Graph &graph, int cliqueSize,
+                                       std::uint64_t seed)
     : initialTemperature(initialTemp), endTemperature(endTemp), coolingCoefficient(coolingCoeff), currentTemperature(initialTemp),
-      graph(graph), m(cliqueSize), n(graph.get_number_of_vertices()), rng(random_device{}()) {
+      graph(graph), m(cliqueSize), n(graph.get_number_of_vertices()), rng(seed),
+      temperatureReset(TemperatureReset::Keep), reheatFactor(2.0), profile("sa") {
     initialize();
 
 }
@@ -21,9 +25,7 @@ void SimulatedAnnealing::initialize() {
     last_clique = {};
     permutation.resize(n);
     iota(permutation.begin(), permutation.end(), 0);
-    random_device rd;
-    mt19937 gen(rd());
-    shuffle(permutation.begin(), permutation.end(), gen);
+    shuffle(permutation.begin(), permutation.end(), rng);
     setupDegrees();
 
 }
@@ -41,9 +43,8 @@ void SimulatedAnnealing::initialize(vector<int> perm) {
 
 void SimulatedAnnealing::setupDegrees() {
     vertexDegrees.resize(n); // 0-based indexing
-    auto adjacency_list = graph.get_adjacency_list();
     for (int i = 0; i < n; ++i) {
-        vertexDegrees[i] = adjacency_list[i].size();
+        vertexDegrees[i] = graph.get_degree(i);
     }
 }
 
@@ -61,6 +62,7 @@ pair<int, int> SimulatedAnnealing::selectVertices() {
     int u = cliqueDist(rng);
     while (attempts < 8 * n) {
         int w = nonCliqueDist(rng);
+        PROFILE_COUNT(profile, Counter::CandidatesExamined, 1);
 
         double f0u = computePartialObjective(u);
         double f0w = computePartialObjective(w);
@@ -73,36 +75,48 @@ pair<int, int> SimulatedAnnealing::selectVertices() {
     return {0, m}; // Default fallback
 }
 
+void SimulatedAnnealing::buildWindowDegrees() {
+    windowDegree.assign(n, 0);
+    for (int i = 0; i < m; ++i) {
+        moveIntoWindow(permutation[i], 1);
+    }
+}
+
+// Add (delta = 1) or remove (delta = -1) a vertex's contribution to windowDegree, O(deg)
+void SimulatedAnnealing::moveIntoWindow(int vertex, int delta) {
+    PROFILE_COUNT(profile, Counter::AdjacencyQueries, 1);
+    for (int neighbour : graph.get_neighbours(vertex)) {
+        windowDegree[neighbour] += delta;
+    }
+}
+
+// Number of non-adjacent pairs among perm[0..m); windowDegree must describe that same window
 double SimulatedAnnealing::computeObjectiveFunction(const vector<int>& perm) {
-    double score = 0;
-    for (int i = 0; i < m-1; i++) {
-        for (int j = i + 1; j < m; j++) {
-            int u = perm[i], v = perm[j];
-            if (!graph.is_edge(u, v)){
-                score += 1;
-            }
-        }
+    long long missing = 0;
+    for (int i = 0; i < m; i++) {
+        missing += m - 1 - windowDegree[perm[i]];
     }
 
-    return score;
+    return missing / 2;
 }
 
 double SimulatedAnnealing::computePartialObjective(int vertexIndex) {
-    double score = 0;
-    for (int i = 0; i < m; ++i) {
-        if (i != vertexIndex) {
-            int u = permutation[vertexIndex];
-            int v = permutation[i];
-            if (graph.is_edge(u, v)){
-                score += 1;
-            }
-            
-        }
-    }
-    return score;
+    return windowDegree[permutation[vertexIndex]];
+}
+
+// Change of F if permutation[u] (in the window) and permutation[w] (outside) were swapped, O(1)
+double SimulatedAnnealing::computeSwapDelta(int u, int w) {
+    int leaving = permutation[u], entering = permutation[w];
+    PROFILE_COUNT(profile, Counter::AdjacencyQueries, 1);
+    // leaving takes (m-1 - windowDegree[leaving]) missing pairs with it, entering brings
+    // its own, not counting the edge to leaving, which is no longer in the window
+    return windowDegree[leaving] - windowDegree[entering] + (graph.is_edge(leaving, entering) ? 1 : 0);
 }
 
 void SimulatedAnnealing::performStateTransition(int u, int w) {
+    // u is inside the clique window and w outside
+    moveIntoWindow(permutation[u], -1);
+    moveIntoWindow(permutation[w], 1);
     swap(permutation[u], permutation[w]);
 }
 
@@ -115,48 +129,138 @@ bool SimulatedAnnealing::acceptNewState(double deltaF) {
     return dist(rng) < probability;
 }
 
-std::vector<int> SimulatedAnnealing::run(){
-    currentF = 0;
-    vector<int> perm;
+void SimulatedAnnealing::setTemperatureReset(TemperatureReset policy, double factor) {
+    temperatureReset = policy;
+    reheatFactor = factor;
+}
 
-    while (currentF == 0){
-        perm = maximum_clique();
-        m+=1;
-    }
-    return perm;
+void SimulatedAnnealing::setStoppingCriteria(const StoppingCriteria &criteria) {
+    stopping = StoppingPolicy(criteria);
 }
 
-std::vector<int> SimulatedAnnealing::maximum_clique() {
-    
-    currentF = computeObjectiveFunction(permutation);
+const StoppingPolicy& SimulatedAnnealing::getStoppingPolicy() const {
+    return stopping;
+}
 
+const SolverProfile& SimulatedAnnealing::getProfile() const {
+    return profile;
+}
 
-    while (currentTemperature > endTemperature) {
-        if (currentF == 0) {
-            last_clique = vector<int>(permutation.begin(), permutation.begin() + m);
-            break; // Solution found
-        }
-        auto [u, w] = selectVertices();
-        performStateTransition(u, w);
+const vector<CliqueSizeStats>& SimulatedAnnealing::getSizeStats() const {
+    return sizeStats;
+}
 
-        double newF = computeObjectiveFunction(permutation);
-        double deltaF = newF - currentF;
+// Cool until the window is a clique (currentF == 0), the schedule ends or a stopping limit is hit;
+// returns the iterations used
+long long SimulatedAnnealing::anneal() {
+    PROFILE_PHASE(profile, Phase::Annealing);
+    long long iterations = 0;
+    if (m >= n) {
+        // No vertex outside the window to swap in
+        return iterations;
+    }
+    while (currentTemperature > endTemperature && currentF != 0 && !stopping.should_stop()) {
+        auto [u, w] = selectVertices();
+        double deltaF = computeSwapDelta(u, w);
 
         if (acceptNewState(deltaF)) {
-            currentF = newF;
+            performStateTransition(u, w);
+            currentF += deltaF;
+            PROFILE_COUNT(profile, Counter::AcceptedMoves, 1);
         } else {
-            performStateTransition(u, w); // Revert the change
+            PROFILE_COUNT(profile, Counter::RejectedMoves, 1);
         }
 
-
         currentTemperature *= coolingCoefficient;
+        ++iterations;
+    }
+    return iterations;
+}
 
+// While some vertex outside the window is adjacent to the whole window, pull it in.
+// Requires currentF == 0; among common neighbours the highest-degree one is taken.
+void SimulatedAnnealing::extendGreedily() {
+    PROFILE_PHASE(profile, Phase::Extension);
+    while (m < n) {
+        int best = -1;
+        for (int i = m; i < n; ++i) {
+            if (windowDegree[permutation[i]] == m && (best == -1 || vertexDegrees[permutation[i]] > vertexDegrees[permutation[best]])) {
+                best = i;
+            }
+        }
+        if (best == -1) {
+            return;
+        }
+        swap(permutation[m], permutation[best]);
+        moveIntoWindow(permutation[m], 1);
+        ++m;
     }
+}
 
-    cout << "Final objective function value: " << currentF <<" clique size: "<< m<< endl;
-	if(currentF == 0)
-		return vector<int>(permutation.begin(), permutation.begin() + m);
-	else
-		return last_clique;
+// Grow the window by the outside vertex with the most neighbours in it, updating currentF
+void SimulatedAnnealing::growWindow() {
+    PROFILE_PHASE(profile, Phase::Extension);
+    int best = m;
+    for (int i = m + 1; i < n; ++i) {
+        if (windowDegree[permutation[i]] > windowDegree[permutation[best]]) {
+            best = i;
+        }
+    }
+    swap(permutation[m], permutation[best]);
+    currentF += m - windowDegree[permutation[m]];
+    moveIntoWindow(permutation[m], 1);
+    ++m;
 }
 
+std::vector<int> SimulatedAnnealing::run(){
+    stopping.start();
+    profile.reset();
+    sizeStats.clear();
+    buildWindowDegrees();
+    currentF = computeObjectiveFunction(permutation);
+
+    while (true) {
+        auto start = chrono::steady_clock::now();
+        int size = m;
+        long long iterations = anneal();
+        bool found = currentF == 0;
+        sizeStats.push_back({size, iterations, chrono::duration<double>(chrono::steady_clock::now() - start).count(), found});
+        cout << "Clique size " << size << ": " << (found ? "found" : "not found") << " after " << iterations
+             << " iterations, " << sizeStats.back().seconds << " s" << endl;
+        if (!found) {
+            break;
+        }
+
+        extendGreedily();
+        last_clique = vector<int>(permutation.begin(), permutation.begin() + m);
+        stopping.improve(m);
+        // Growing to n cannot give a clique: extendGreedily left no outside vertex adjacent to the whole window
+        if (m + 1 >= n || stopping.target_reached()) {
+            break;
+        }
+        growWindow();
+
+        if (temperatureReset == TemperatureReset::Restart) {
+            currentTemperature = initialTemperature;
+        } else if (temperatureReset == TemperatureReset::Reheat) {
+            currentTemperature = min(initialTemperature, currentTemperature * reheatFactor);
+        }
+    }
+    return last_clique;
+}
+
+std::vector<int> SimulatedAnnealing::maximum_clique() {
+    stopping.start();
+    profile.reset();
+    buildWindowDegrees();
+    currentF = computeObjectiveFunction(permutation);
+
+    anneal();
+
+    cout << "Final objective function value: " << currentF <<" clique size: "<< m<< endl;
+	if(currentF == 0) {
+		stopping.improve(m);
+		return last_clique = vector<int>(permutation.begin(), permutation.begin() + m);
+	}
+	return last_clique;
+}
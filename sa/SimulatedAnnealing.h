@@ -2,6 +2,9 @@
 #define SIMULATED_ANNEALING_H
 
 #include "../graph/graph.h"
+#include "../common/stopping.h"
+#include "../common/profile.h"
+#include <cstdint>
 #include <vector>
 #include <set>
 #include <random>
@@ -10,8 +13,22 @@
 #include <iostream>
 #include <random>
 #include <cmath>
+#include <chrono>
 using namespace std;
 
+// What happens to the temperature when run() moves from a k-clique to the k+1 search
+enum class TemperatureReset {
+    Keep,    // keep cooling from the current temperature (one schedule for every k)
+    Restart, // go back to the initial temperature
+    Reheat   // multiply the current temperature by reheatFactor, up to the initial one
+};
+
+struct CliqueSizeStats {
+    int cliqueSize;
+    long long iterations;
+    double seconds;
+    bool found;
+};
 
 class SimulatedAnnealing {
 private:
@@ -21,33 +38,57 @@ private:
     double currentTemperature;
     double currentF;
 
-    Graph graph;
+    const Graph &graph;
     int m; // Size of the clique
     int n; // Number of vertices in the graph
 
     vector<int> permutation;
 	vector<int> last_clique;
     vector<int> vertexDegrees;
+    vector<int> windowDegree; // windowDegree[v] = |N(v) & permutation[0..m)|
 
     mt19937 rng;
 
+    TemperatureReset temperatureReset;
+    double reheatFactor;
+    vector<CliqueSizeStats> sizeStats;
+    StoppingPolicy stopping; // Counts temperature steps; no limits unless set
+    SolverProfile profile;
+
     void initialize();
     void initialize(vector<int> perm);
     void setupDegrees();
     void adjustPermutation();
+    void buildWindowDegrees();
+    void moveIntoWindow(int vertex, int delta);
     pair<int, int> selectVertices();
     double computeObjectiveFunction(const vector<int>& perm);
     double computePartialObjective(int vertexIndex);
+    double computeSwapDelta(int u, int w);
     void performStateTransition(int u, int w);
     bool acceptNewState(double deltaF);
+    long long anneal();
+    void extendGreedily();
+    void growWindow();
 
 public:
-    SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, Graph graph, int cliqueSize, std::vector<int> perm);
+    // Runs with the same seed start from the same permutation and make the same moves
+    SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, const Graph &graph, int cliqueSize, std::vector<int> perm,
+                       std::uint64_t seed = std::random_device{}());
 
-    SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, Graph graph, int cliqueSize);
+    SimulatedAnnealing(double initialTemp, double endTemp, double coolingCoeff, const Graph &graph, int cliqueSize,
+                       std::uint64_t seed = std::random_device{}());
 
+    void setTemperatureReset(TemperatureReset policy, double factor = 2.0);
+    // Limits on top of the end temperature; the target is a clique size
+    void setStoppingCriteria(const StoppingCriteria &criteria);
+    const StoppingPolicy &getStoppingPolicy() const;
+    // Counters and phase times of the last run; all zero unless built with CLIQUE_PROFILE
+    const SolverProfile &getProfile() const;
+    // Incremental k-search: anneal for size m, extend the clique greedily and carry the state into m+1
     std::vector<int> run();
     std::vector<int> maximum_clique();
+    const vector<CliqueSizeStats>& getSizeStats() const;
 };
 
 #endif // SIMULATED_ANNEALING_H
@@ -1,6 +1,11 @@
 #include "../ga/ga.h"
 #include "../ts/tabusearch.h"
 #include "../sa/SimulatedAnnealing.h"
+#include "../bnb/branch_and_bound.h"
+#include "../graph/reduction.h"
+#include "../portfolio/portfolio.h"
+#include "../batch/batch.h"
+#include "../tuning/ga_tuning.h"
 #include <cstdlib>
 #include <string>
 #include <filesystem>
@@ -9,6 +14,13 @@
 #include <string>
 #include <fstream>
 #include <dirent.h>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <memory>
+#include <limits>
 
 std::string extract_file_name(const std::string &file_path)
 {
@@ -26,7 +38,63 @@ std::string extract_file_name(const std::string &file_path)
 	return file_name;
 }
 
-void control_test(const std::string &graph_file, int num_executions, const std::string &output_file)
+// Reduz o grafo antes das heuristicas; as cliques do grafo reduzido valem no original
+ReductionResult reduce_and_report(const Graph &g, bool triangle_pruning = false)
+{
+	ReductionResult reduced = reduce_graph(g, triangle_pruning);
+	std::cout << "Reducao: limite inferior " << reduced.lower_bound << ", " << g.get_number_of_vertices() << " -> "
+			  << reduced.graph.get_number_of_vertices() << " vertices, " << g.get_number_of_edges() << " -> "
+			  << reduced.graph.get_number_of_edges() << " arestas";
+	if (triangle_pruning)
+		std::cout << " (" << reduced.removed_edges << " arestas e " << reduced.removed_by_triangles
+				  << " vertices podados por triangulos)";
+	std::cout << std::endl;
+	return reduced;
+}
+
+// Rotulos do arquivo de entrada de uma clique do grafo reduzido, separados por espaco (uma coluna do CSV)
+std::string format_clique(const ReductionResult &reduced, const std::vector<int> &clique)
+{
+	std::string labels;
+	for (int label : reduced.to_labels(clique))
+	{
+		if (!labels.empty())
+			labels += ' ';
+		labels += std::to_string(label);
+	}
+	return labels;
+}
+
+// Curvas de convergencia: uma linha por melhora da melhor clique de cada solver
+const char *TRACE_FILE = "convergence_trace.csv";
+
+bool is_new_file(const std::string &path)
+{
+	return !std::filesystem::exists(path) || std::filesystem::file_size(path) == 0;
+}
+
+std::string trace_header()
+{
+	return std::string("graph_file_pretty,execution,solver,") + ConvergenceTrace::CSV_COLUMNS;
+}
+
+// Abre TRACE_FILE para acrescentar linhas, escrevendo o cabecalho se o arquivo for novo
+std::ofstream open_trace_file()
+{
+	bool is_new = is_new_file(TRACE_FILE);
+	std::ofstream trace_out(TRACE_FILE, std::ios::app);
+	if (is_new)
+		trace_out << trace_header() << std::endl;
+	return trace_out;
+}
+
+// Linhas de TRACE_FILE de uma execucao de um solver, sem o ultimo fim de linha
+std::string trace_rows(const std::string &graph_file_pretty, int execution, const char *solver, const ConvergenceTrace &trace)
+{
+	return trace.to_csv(graph_file_pretty + "," + std::to_string(execution) + "," + solver);
+}
+
+void control_test(const std::string &graph_file, int num_executions, const std::string &output_file, bool trace = false)
 {
 	std::ofstream out(output_file, std::ios::app);
 	if (!out.is_open())
@@ -36,7 +104,12 @@ void control_test(const std::string &graph_file, int num_executions, const std::
 	}
 	std::string graph_file_pretty = extract_file_name(graph_file);
 	Graph g;
-	g.read_edge_list(graph_file);
+	if (!g.load(graph_file))
+	{
+		std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << graph_file << std::endl;
+		return;
+	}
+	g.print_load_statistics(std::cout);
 
 	int best_clique = 0;
 	double total_time = 0.0;
@@ -45,6 +118,14 @@ void control_test(const std::string &graph_file, int num_executions, const std::
 		auto start = std::chrono::high_resolution_clock::now();
 
 		SimulatedAnnealing sa(100.0, 0.001, 0.9995, g, 1);
+		std::unique_ptr<ConvergenceTrace> sa_trace;
+		if (trace)
+		{
+			sa_trace = std::make_unique<ConvergenceTrace>();
+			StoppingCriteria criteria;
+			criteria.trace = sa_trace.get();
+			sa.setStoppingCriteria(criteria);
+		}
 		std::cout << "Running simulated annealing algorithm..." << std::endl;
 		std::vector<int> clique = sa.run();
 		int clique_size_sa = clique.size();
@@ -61,12 +142,144 @@ void control_test(const std::string &graph_file, int num_executions, const std::
 		double exec_time = std::chrono::duration<double>(end - start).count();
 
 		out << (i + 1) << "," << graph_file_pretty << "," << cur_clique << "," << exec_time << std::endl;
+		if (sa_trace && sa_trace->size() > 0)
+			open_trace_file() << trace_rows(graph_file_pretty, i + 1, "sa", *sa_trace) << std::endl;
 	}
 	std::cout << "Melhor clique em 20 execucoes = " << best_clique << std::endl;
 	std::cout << "Tempo de execucao total: " << total_time << " seconds" << std::endl;
 }
 
-void test(const std::string &graph_file, int num_executions, const std::string &output_file)
+// Resultado de uma execucao de GA -> SA -> busca tabu
+struct HeuristicsRun
+{
+	int clique_size_ga;
+	int clique_size_sa;
+	int cur_clique;
+	double exec_time;
+	double exec_time_ga;
+	double exec_time_sa;
+	double exec_time_ts;
+	double time_to_target; // Segundos ate a primeira etapa chegar ao alvo, ou -1
+	std::vector<int> clique; // Melhor clique da busca tabu, em vertices do grafo dado a run_heuristics
+	std::string profile; // Array JSON com o perfil de cada solver; so em builds com CLIQUE_PROFILE
+	// So alocados com trace, antes de os solvers comecarem, para a gravacao nao atrapalhar os tempos acima
+	std::unique_ptr<ConvergenceTrace> ga_trace;
+	std::unique_ptr<ConvergenceTrace> sa_trace;
+	std::unique_ptr<ConvergenceTrace> ts_trace;
+};
+
+// Com target, cada etapa para assim que chega a uma clique desse tamanho
+HeuristicsRun run_heuristics(const Graph &h, bool trace = false, int target = std::numeric_limits<int>::max())
+{
+#ifdef CLIQUE_PROFILE
+	// Os perfis tiram dos traces a trajetoria da melhor clique ate o momento
+	trace = true;
+#endif
+	HeuristicsRun run;
+	if (trace)
+	{
+		run.ga_trace = std::make_unique<ConvergenceTrace>();
+		run.sa_trace = std::make_unique<ConvergenceTrace>();
+		run.ts_trace = std::make_unique<ConvergenceTrace>();
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+
+	GeneticAlgorithm ga(h, 100, 0.9, 0.1, 100);
+	ga.set_stopping_criteria(StoppingCriteria{.max_iterations = 100, .target = target, .trace = run.ga_trace.get()});
+	std::cout << "Running genetic algorithm..." << std::endl;
+	auto start_ga = std::chrono::high_resolution_clock::now();
+	std::vector<int> clique = ga.run();
+	auto end_ga = std::chrono::high_resolution_clock::now();
+	run.clique_size_ga = clique.size();
+	std::cout << "Clique size ga: " << run.clique_size_ga << std::endl;
+	SimulatedAnnealing sa(100.0, 0.001, 0.9995, h, run.clique_size_ga, clique);
+	sa.setStoppingCriteria(StoppingCriteria{.target = target, .trace = run.sa_trace.get()});
+	std::cout << "Running simulated annealing algorithm..." << std::endl;
+	auto start_sa = std::chrono::high_resolution_clock::now();
+	clique = sa.run();
+	auto end_sa = std::chrono::high_resolution_clock::now();
+	run.clique_size_sa = clique.size();
+	std::cout << "Clique size sa: " << run.clique_size_sa << std::endl;
+
+	std::cout << "Running tabu search..." << std::endl;
+	TabuSearch ts(h, clique, 10, 100);
+	ts.setStoppingCriteria(StoppingCriteria{.max_iterations = 100, .target = target, .trace = run.ts_trace.get()});
+	auto start_ts = std::chrono::high_resolution_clock::now();
+	ts.run();
+	auto end_ts = std::chrono::high_resolution_clock::now();
+
+	run.cur_clique = ts.getBestClique();
+	run.clique = ts.getBestSolution();
+	std::cout << "Clique size ts: " << run.cur_clique << std::endl;
+	std::cout << "Done" << std::endl;
+	auto end = std::chrono::high_resolution_clock::now();
+
+	run.exec_time = std::chrono::duration<double>(end - start).count();
+	run.exec_time_ga = std::chrono::duration<double>(end_ga - start_ga).count();
+	run.exec_time_sa = std::chrono::duration<double>(end_sa - start_sa).count();
+	run.exec_time_ts = std::chrono::duration<double>(end_ts - start_ts).count();
+	// O tempo ate o alvo de cada etapa conta do inicio dela
+	auto since_start = [&start](std::chrono::high_resolution_clock::time_point t)
+	{ return std::chrono::duration<double>(t - start).count(); };
+	run.time_to_target = -1.0;
+	if (ga.get_stopping_policy().get_time_to_target() >= 0.0)
+		run.time_to_target = since_start(start_ga) + ga.get_stopping_policy().get_time_to_target();
+	else if (sa.getStoppingPolicy().get_time_to_target() >= 0.0)
+		run.time_to_target = since_start(start_sa) + sa.getStoppingPolicy().get_time_to_target();
+	else if (ts.getStoppingPolicy().get_time_to_target() >= 0.0)
+		run.time_to_target = since_start(start_ts) + ts.getStoppingPolicy().get_time_to_target();
+#ifdef CLIQUE_PROFILE
+	std::ostringstream profile;
+	profile << "[";
+	ga.get_profile().write_json(profile, ga.get_stopping_policy());
+	profile << ",";
+	sa.getProfile().write_json(profile, sa.getStoppingPolicy());
+	profile << ",";
+	ts.getProfile().write_json(profile, ts.getStoppingPolicy());
+	profile << "]";
+	run.profile = profile.str();
+#endif
+	return run;
+}
+
+const char *HEURISTICS_HEADER = ",graph_file_pretty,clique_size_ga,clique_size_sa,cur_clique,exec_time,exec_time_ga,exec_time_sa,exec_time_ts,time_to_target,clique"; // columns names
+
+// run veio do grafo reduzido `reduced`; a clique sai com os rotulos do arquivo de entrada
+std::string heuristics_row(int execution, const std::string &graph_file_pretty, const HeuristicsRun &run, const ReductionResult &reduced)
+{
+	std::ostringstream row;
+	row << execution << "," << graph_file_pretty << "," << run.clique_size_ga << ","
+		<< run.clique_size_sa << "," << run.cur_clique << "," << run.exec_time << ","
+		<< run.exec_time_ga << "," << run.exec_time_sa << "," << run.exec_time_ts << ","
+		<< run.time_to_target << "," << format_clique(reduced, run.clique);
+	return row.str();
+}
+
+// Uma linha de profile.jsonl por execucao
+std::string profile_line(int execution, const std::string &graph_file_pretty, const HeuristicsRun &run)
+{
+	return "{\"execution\":" + std::to_string(execution) + ",\"graph_file_pretty\":\"" + graph_file_pretty +
+		   "\",\"solvers\":" + run.profile + "}";
+}
+
+// Linhas de TRACE_FILE de uma execucao de GA -> SA -> busca tabu
+std::string heuristics_trace_rows(int execution, const std::string &graph_file_pretty, const HeuristicsRun &run)
+{
+	std::string rows;
+	const std::pair<const char *, const ConvergenceTrace *> traces[] = {{"ga", run.ga_trace.get()}, {"sa", run.sa_trace.get()}, {"ts", run.ts_trace.get()}};
+	for (const auto &[solver, trace] : traces)
+	{
+		if (!trace || trace->size() == 0)
+			continue;
+		if (!rows.empty())
+			rows += '\n';
+		rows += trace_rows(graph_file_pretty, execution, solver, *trace);
+	}
+	return rows;
+}
+
+void test(const std::string &graph_file, int num_executions, const std::string &output_file, bool trace = false,
+		  bool triangle_pruning = false, int target = std::numeric_limits<int>::max())
 {
 	std::ofstream out(output_file, std::ios::app);
 	if (!out.is_open())
@@ -76,61 +289,79 @@ void test(const std::string &graph_file, int num_executions, const std::string &
 	}
 	std::string graph_file_pretty = extract_file_name(graph_file);
 	Graph g;
-	g.read_edge_list(graph_file);
+	if (!g.load(graph_file))
+	{
+		std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << graph_file << std::endl;
+		return;
+	}
+	g.print_load_statistics(std::cout);
+	ReductionResult reduced = reduce_and_report(g, triangle_pruning);
+	const Graph &h = reduced.graph;
 
 	int best_clique = 0;
 	double total_time = 0.0;
-	out << ",graph_file_pretty,clique_size_ga,clique_size_sa,cur_clique,exec_time,exec_time_ga,exec_time_sa,exec_time_ts\n"; // columns names
+	out << HEURISTICS_HEADER << "\n";
 	for (int i = 0; i < num_executions; ++i)
 	{
-		auto start = std::chrono::high_resolution_clock::now();
-
-		GeneticAlgorithm ga(g, 100, 0.9, 0.1, 100);
-		std::cout << "Running genetic algorithm..." << std::endl;
-		auto start_ga = std::chrono::high_resolution_clock::now();
-		std::vector<int> clique = ga.run();
-		auto end_ga = std::chrono::high_resolution_clock::now();
-		int clique_size_ga = clique.size();
-		std::cout << "Clique size ga: " << clique_size_ga << std::endl;
-		SimulatedAnnealing sa(100.0, 0.001, 0.9995, g, clique_size_ga, clique);
-		std::cout << "Running simulated annealing algorithm..." << std::endl;
-		auto start_sa = std::chrono::high_resolution_clock::now();
-		clique = sa.run();
-		auto end_sa = std::chrono::high_resolution_clock::now();
-		int clique_size_sa = clique.size();
-		std::cout << "Clique size sa: " << clique_size_sa << std::endl;
-
-		std::cout << "Running tabu search..." << std::endl;
-		TabuSearch ts(g, clique, 10, 100);
-		auto start_ts = std::chrono::high_resolution_clock::now();
-		ts.run();
-		auto end_ts = std::chrono::high_resolution_clock::now();
-
-		int cur_clique = ts.getBestClique();
-		std::cout << "Clique size ts: " << cur_clique << std::endl;
-		std::cout << "Done" << std::endl;
-		if (cur_clique > best_clique)
+		HeuristicsRun run = run_heuristics(h, trace, target);
+		if (run.cur_clique > best_clique)
 		{
-			best_clique = cur_clique;
+			best_clique = run.cur_clique;
 		}
-		auto end = std::chrono::high_resolution_clock::now();
-
-		total_time += std::chrono::duration<double>(end - start).count();
-		double exec_time = std::chrono::duration<double>(end - start).count();
-		double exec_time_ga = std::chrono::duration<double>(end_ga - start_ga).count();
-		double exec_time_sa = std::chrono::duration<double>(end_sa - start_sa).count();
-		double exec_time_ts = std::chrono::duration<double>(end_ts - start_ts).count();
-
-		out << (i + 1) << "," << graph_file_pretty << "," << clique_size_ga << ","
-			<< clique_size_sa << "," << cur_clique << "," << exec_time << "," 
-			<< exec_time_ga<<"," << exec_time_sa<<"," << exec_time_ts<<std::endl;
+		total_time += run.exec_time;
+		out << heuristics_row(i + 1, graph_file_pretty, run, reduced) << std::endl;
+#ifdef CLIQUE_PROFILE
+		std::ofstream("profile.jsonl", std::ios::app) << profile_line(i + 1, graph_file_pretty, run) << std::endl;
+#endif
+		if (trace)
+			open_trace_file() << heuristics_trace_rows(i + 1, graph_file_pretty, run) << std::endl;
 	}
 	std::cout << "Melhor clique em 20 execucoes = " << best_clique << std::endl;
 	std::cout << "Tempo de execucao total: " << total_time << " seconds" << std::endl;
 }
 
+// Prova a otimalidade com branch and bound, partindo da melhor clique da busca tabu
+void exact_test(const std::string &graph_file, double time_limit, const std::string &output_file, bool triangle_pruning = false)
+{
+	std::ofstream out(output_file, std::ios::app);
+	if (!out.is_open())
+	{
+		std::cerr << "Erro ao abrir o arquivo de output: " << output_file << std::endl;
+		return;
+	}
+	std::string graph_file_pretty = extract_file_name(graph_file);
+	Graph g;
+	if (!g.load(graph_file))
+	{
+		std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << graph_file << std::endl;
+		return;
+	}
+	g.print_load_statistics(std::cout);
+	ReductionResult reduced = reduce_and_report(g, triangle_pruning);
+
+	TabuSearch ts(reduced.graph, {}, 10, 100000);
+	ts.run();
+	BranchAndBound bnb(reduced.graph, ts.getBestSolution());
+	if (!bnb.fits_in_memory())
+		std::cerr << "Grafo reduzido grande demais para o branch and bound, fica a clique da busca tabu: " << graph_file << std::endl;
+	StoppingCriteria criteria;
+	criteria.time_limit = time_limit;
+	bnb.set_stopping_criteria(criteria);
+	ExactResult result = bnb.run();
 
-void grid_search_ga(const std::string &graph_file, int num_executions, const std::string &output_file)
+	std::cout << "Clique size ts: " << ts.getBestClique() << std::endl;
+	std::cout << "Clique size bnb: " << result.clique.size() << (result.optimal ? " (otima)" : "")
+			  << ", limite superior " << result.upper_bound << ", " << result.nodes << " nos, "
+			  << result.seconds << " seconds" << std::endl;
+	std::cout << "Clique: " << format_clique(reduced, result.clique) << std::endl;
+	out << graph_file_pretty << "," << ts.getBestClique() << "," << result.clique.size() << ","
+		<< result.optimal << "," << result.upper_bound << "," << result.nodes << "," << result.seconds << ","
+		<< format_clique(reduced, result.clique) << std::endl;
+}
+
+// Corre GA, SA, busca tabu e branch and bound em paralelo, uma thread por nucleo, compartilhando a melhor clique
+void portfolio_test(const std::string &graph_file, double time_limit, int threads, const std::string &output_file, bool trace = false,
+					bool triangle_pruning = false, int target = std::numeric_limits<int>::max())
 {
 	std::ofstream out(output_file, std::ios::app);
 	if (!out.is_open())
@@ -140,41 +371,102 @@ void grid_search_ga(const std::string &graph_file, int num_executions, const std
 	}
 	std::string graph_file_pretty = extract_file_name(graph_file);
 	Graph g;
-	g.read_edge_list(graph_file);
+	if (!g.load(graph_file))
+	{
+		std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << graph_file << std::endl;
+		return;
+	}
+	g.print_load_statistics(std::cout);
+	ReductionResult reduced = reduce_and_report(g, triangle_pruning);
 
-	std::vector<double> list_pcs = {0.9, 0.8, 0.7};
-	std::vector<double> list_pms = {0.3, 0.2, 0.1};
-	std::vector<int> list_pop = {100, 200, 300};
-	std::vector<int> list_gens = {100, 200, 300};
-	out << ",graph_file_pretty,clique_size_ga,exec_time_ga,pc,pm,pop,gens\n"; // column names
-	for (auto const pc : list_pcs)
+	std::unique_ptr<ConvergenceTrace> portfolio_trace;
+	StoppingCriteria criteria;
+	criteria.time_limit = time_limit;
+	criteria.target = target;
+	if (trace)
 	{
-		for (auto const pm : list_pms)
-		{
-			for (auto const pop : list_pop)
-			{
-				for (auto const gens : list_gens)
-				{
-					for (int i = 0; i < num_executions; ++i)
-					{
-						auto start = std::chrono::high_resolution_clock::now();
-						GeneticAlgorithm ga(g, pop, pc, pm, gens);
-						std::cout << "Running genetic algorithm..." << std::endl;
-						std::vector<int> clique = ga.run();
-						int clique_size_ga = clique.size();
-						std::cout << "Clique size ga: " << clique_size_ga << std::endl;
-						double exec_time_ga = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
-						out << (i + 1) << "," << graph_file_pretty << "," << clique_size_ga << "," << exec_time_ga << ","
-							<< pc << "," << pm << "," << pop << "," << gens << std::endl;
-					}
-				}
-			}
-		}
+		portfolio_trace = std::make_unique<ConvergenceTrace>();
+		criteria.trace = portfolio_trace.get();
 	}
+	Portfolio portfolio(reduced.graph, criteria);
+	portfolio.add_default_members(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+	PortfolioResult result = portfolio.run();
+
+	// Vazio se nenhum membro publicou uma clique
+	const char *solver_names[] = {"ga", "sa", "ts", "bnb", ""};
+	const char *found_by = solver_names[(int)result.found_by];
+	std::cout << "Clique size portfolio: " << result.clique.size() << (result.optimal ? " (otima)" : "");
+	if (result.found_by != PortfolioSolver::None)
+		std::cout << ", encontrada por " << found_by << " em " << result.time_to_best << " s";
+	std::cout << ", " << result.runs << " execucoes, " << result.seconds << " seconds" << std::endl;
+	std::cout << "Clique: " << format_clique(reduced, result.clique) << std::endl;
+	out << graph_file_pretty << "," << result.clique.size() << "," << result.optimal << "," << found_by << ","
+		<< result.time_to_best << "," << result.time_to_target << "," << result.runs << "," << result.seconds << ","
+		<< format_clique(reduced, result.clique) << std::endl;
+	if (portfolio_trace && portfolio_trace->size() > 0)
+		open_trace_file() << trace_rows(graph_file_pretty, 1, "portfolio", *portfolio_trace) << std::endl;
 }
 
-void test_all_files_in_directory(const std::string &directory_path, int num_executions, const std::string &output_file)
+void print_tuning_results(const std::vector<TuningResult> &results, int count)
 {
+	for (int i = 0; i < std::min(count, (int)results.size()); ++i)
+	{
+		const TuningResult &result = results[i];
+		std::cout << "pc " << result.parameters.crossover_probability << ", pm " << result.parameters.mutation_probability
+				  << ", pop " << result.parameters.population_size << ", gens " << result.parameters.generations << ": media "
+				  << result.mean_clique << ", melhor " << result.best_clique << ", " << result.mean_seconds << " s em "
+				  << result.runs << " execucoes" << std::endl;
+	}
+}
+
+// Grade de parametros do GA; retoma de output_file, que ja lista as execucoes feitas.
+// first_rung > 0 liga o successive halving, comecando com first_rung execucoes por configuracao.
+void grid_search_ga(const std::string &graph_file, int num_executions, const std::string &output_file, int first_rung = 0, int threads = 0)
+{
+	std::string graph_file_pretty = extract_file_name(graph_file);
+	Graph g;
+	if (!g.load(graph_file))
+	{
+		std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << graph_file << std::endl;
+		return;
+	}
+	g.print_load_statistics(std::cout);
+
+	GaParameterSpace space{{0.9, 0.8, 0.7}, {0.3, 0.2, 0.1}, {100, 200, 300}, {100, 200, 300}};
+	TuningOptions options;
+	options.repetitions = num_executions;
+	options.first_rung = first_rung;
+	options.threads = threads;
+	GaTuner tuner(g, graph_file_pretty, output_file);
+	print_tuning_results(tuner.run(space.grid(), options), 5);
+}
+
+// Como grid_search_ga, mas com num_samples configuracoes sorteadas nos mesmos intervalos
+void random_search_ga(const std::string &graph_file, int num_samples, int num_executions, const std::string &output_file,
+					  int first_rung = 1, int threads = 0, std::uint64_t seed = 0)
+{
+	std::string graph_file_pretty = extract_file_name(graph_file);
+	Graph g;
+	if (!g.load(graph_file))
+	{
+		std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << graph_file << std::endl;
+		return;
+	}
+	g.print_load_statistics(std::cout);
+
+	GaParameterSpace space{{0.7, 0.9}, {0.1, 0.3}, {100, 300}, {100, 300}};
+	TuningOptions options;
+	options.repetitions = num_executions;
+	options.first_rung = first_rung;
+	options.threads = threads;
+	GaTuner tuner(g, graph_file_pretty, output_file);
+	print_tuning_results(tuner.run(space.sample(num_samples, seed), options), 5);
+}
+
+// Arquivos DIMACS do diretorio, em ordem alfabetica
+std::vector<std::string> list_instances(const std::string &directory_path)
+{
+	std::vector<std::string> files;
 	DIR *dir;
 	struct dirent *ent;
 	if ((dir = opendir(directory_path.c_str())) != NULL)
@@ -182,11 +474,10 @@ void test_all_files_in_directory(const std::string &directory_path, int num_exec
 		while ((ent = readdir(dir)) != NULL)
 		{
 			std::string file_name = ent->d_name;
-			if (file_name != "." && file_name != "..")
+			// Only DIMACS files; skips "." and ".." and the binary caches written next to them
+			if (file_name.size() > 4 && file_name.compare(file_name.size() - 4, 4, ".clq") == 0)
 			{
-				std::string file_path = directory_path + "/" + file_name;
-				std::cout << "Testing file: " << file_path << std::endl;
-				test(file_path, num_executions, output_file);
+				files.push_back(directory_path + "/" + file_name);
 			}
 		}
 		closedir(dir);
@@ -195,21 +486,150 @@ void test_all_files_in_directory(const std::string &directory_path, int num_exec
 	{
 		std::cerr << "Erro ao abrir o diretório: " << directory_path << std::endl;
 	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+void test_all_files_in_directory(const std::string &directory_path, const std::function<void(const std::string &)> &test_file)
+{
+	for (const std::string &file_path : list_instances(directory_path))
+	{
+		std::cout << "Testing file: " << file_path << std::endl;
+		test_file(file_path);
+	}
+}
+
+// Mesmo experimento de test() para todas as instancias do diretorio, com cada (instancia, execucao)
+// como um job independente; as instancias maiores comecam primeiro
+void batch_test(const std::string &directory_path, int num_executions, const std::string &output_file, int threads, bool trace = false,
+				bool triangle_pruning = false, int target = std::numeric_limits<int>::max())
+{
+	CsvWriter out(output_file);
+	if (!out.is_open())
+	{
+		std::cerr << "Erro ao abrir o arquivo de output: " << output_file << std::endl;
+		return;
+	}
+	// Cada instancia e carregada e reduzida uma vez; os jobs so leem o grafo reduzido
+	std::vector<std::string> names;
+	std::vector<ReductionResult> instances;
+	for (const std::string &file_path : list_instances(directory_path))
+	{
+		std::cout << "Loading file: " << file_path << std::endl;
+		Graph g;
+		if (!g.load(file_path))
+		{
+			std::cerr << "Erro ao carregar o grafo, instancia ignorada: " << file_path << std::endl;
+			continue;
+		}
+		g.print_load_statistics(std::cout);
+		names.push_back(extract_file_name(file_path));
+		instances.push_back(reduce_and_report(g, triangle_pruning));
+	}
+
+	BatchRunner runner(threads);
+	for (int i = 0; i < (int)instances.size(); ++i)
+	{
+		const Graph &h = instances[i].graph;
+		for (int r = 0; r < num_executions; ++r)
+			runner.add_job(i, 0, r, h.get_number_of_vertices() + (double)h.get_number_of_edges());
+	}
+	std::cout << "Rodando " << instances.size() * num_executions << " execucoes em " << runner.get_threads() << " threads" << std::endl;
+
+	std::mutex best_mutex;
+	std::vector<int> best_clique(instances.size(), 0);
+	std::vector<double> total_time(instances.size(), 0.0);
+	out.write_row(HEURISTICS_HEADER);
+#ifdef CLIQUE_PROFILE
+	CsvWriter profile_out("profile.jsonl");
+#endif
+	bool new_trace_file = is_new_file(TRACE_FILE);
+	std::unique_ptr<CsvWriter> trace_out;
+	if (trace)
+	{
+		trace_out = std::make_unique<CsvWriter>(TRACE_FILE);
+		if (new_trace_file)
+			trace_out->write_row(trace_header());
+	}
+	runner.run([&](const BatchJob &job)
+			   {
+		HeuristicsRun run = run_heuristics(instances[job.instance].graph, trace, target);
+		out.write_row(heuristics_row(job.repetition + 1, names[job.instance], run, instances[job.instance]));
+#ifdef CLIQUE_PROFILE
+		profile_out.write_row(profile_line(job.repetition + 1, names[job.instance], run));
+#endif
+		std::string rows = trace ? heuristics_trace_rows(job.repetition + 1, names[job.instance], run) : "";
+		if (!rows.empty())
+			trace_out->write_row(rows);
+		std::lock_guard<std::mutex> lock(best_mutex);
+		best_clique[job.instance] = std::max(best_clique[job.instance], run.cur_clique);
+		total_time[job.instance] += run.exec_time; });
+
+	for (int i = 0; i < (int)instances.size(); ++i)
+	{
+		std::cout << names[i] << ": melhor clique em " << num_executions << " execucoes = " << best_clique[i]
+				  << ", tempo de execucao total: " << total_time[i] << " seconds" << std::endl;
+	}
 }
 
 int main(int argc, char **argv)
 {
-	if (argc != 2)
+	// <diretorio> [--portfolio <segundos> | --grid-search] [--threads <n>] [--trace] [--triangles] [--target <k>]
+	std::string directory_path;
+	double portfolio_time = -1.0;
+	bool grid_search = false;
+	bool trace = false;
+	bool triangle_pruning = false;
+	int threads = 0;
+	int target = std::numeric_limits<int>::max();
+	bool usage = false;
+	for (int i = 1; i < argc; ++i)
 	{
-		std::cerr << "Usage: " << argv[0] << " <directory path>" << std::endl;
+		std::string arg = argv[i];
+		if (arg == "--portfolio" && i + 1 < argc)
+			portfolio_time = std::atof(argv[++i]);
+		else if (arg == "--grid-search")
+			grid_search = true;
+		else if (arg == "--trace")
+			trace = true;
+		else if (arg == "--triangles")
+			triangle_pruning = true;
+		else if (arg == "--target" && i + 1 < argc)
+			target = std::atoi(argv[++i]);
+		else if (arg == "--threads" && i + 1 < argc)
+			threads = std::atoi(argv[++i]);
+		else if (directory_path.empty() && arg.rfind("--", 0) != 0)
+			directory_path = arg;
+		else
+			usage = true;
+	}
+	if (usage || directory_path.empty())
+	{
+		std::cerr << "Usage: " << argv[0] << " <directory path> [--portfolio <seconds> | --grid-search] [--threads <n>] [--trace] [--triangles] [--target <k>]" << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
-	std::string directory_path = argv[1];
+	if (portfolio_time >= 0.0)
+	{
+		test_all_files_in_directory(directory_path, [portfolio_time, threads, trace, triangle_pruning, target](const std::string &file_path)
+									{ portfolio_test(file_path, portfolio_time, threads, "portfolio_test.csv", trace, triangle_pruning, target); });
+		return 0;
+	}
+
+	if (grid_search)
+	{
+		// 5 execucoes por configuracao, descartando as piores depois de 1 e de 3; um arquivo por versao
+		// do GA, pois grid_search_ga.csv tem resultados da versao original
+		std::string output_file = "grid_search_ga_v" + std::to_string(GeneticAlgorithm::VERSION) + ".csv";
+		test_all_files_in_directory(directory_path, [threads, output_file](const std::string &file_path)
+									{ grid_search_ga(file_path, 5, output_file, 1, threads); });
+		return 0;
+	}
+
 	int num_executions = 20;
 	std::string output_file = "heuristics_test.csv";
 
-	test_all_files_in_directory(directory_path, num_executions, output_file);
+	batch_test(directory_path, num_executions, output_file, threads, trace, triangle_pruning, target);
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -1,118 +1,245 @@
 #include "tabusearch.h"
 #include "../graph/graph.h"
 #include <algorithm>
-#include <deque>
 #include <iostream>
-#include <unordered_set>
 #include <vector>
 
 TabuSearch::TabuSearch(const Graph &graph, const std::vector<int> &initialSolution,
-                       int maxTabuSize, int maxIterations)
+                       int maxTabuSize, int maxIterations, std::uint64_t seed)
     : graph(graph), currentSolution(initialSolution),
       bestSolution(initialSolution),bestClique(0), maxTabuSize(maxTabuSize),
-      maxIterations(maxIterations) {}
-
-void TabuSearch::run() {
-  std::deque<std::vector<int>> tabuList;
-  int currentIteration = 0;
-  int bestFitness = computeObjectiveFunction(bestSolution);
+      rng(seed, 0), stallPolicy(StallPolicy::Restart),
+      stallIterations(4000), clique(graph.get_number_of_vertices()),
+      members(graph.get_number_of_vertices()), addCandidates(graph.get_number_of_vertices()),
+      swapCandidates(graph.get_number_of_vertices()), miss(graph.get_number_of_vertices(), 0),
+      tabuUntil(graph.get_number_of_vertices(), 0),
+      stopping(StoppingCriteria{.max_iterations = maxIterations}), profile("ts") {
+  bestSolution.reserve(graph.get_number_of_vertices());
+  currentSolution.reserve(graph.get_number_of_vertices());
+}
 
-  while (currentIteration < maxIterations) {
-    if(currentIteration % 10 == 0)
-      std::cout << "Iteration: " << currentIteration << std::endl;
-    std::vector<std::vector<int>> neighborhood =
-        generateNeighborhood(currentSolution, tabuList);
+void TabuSearch::initialize(const std::vector<int> &solution) {
+  assert(isClique(solution) && "Solution is not a clique.");
+  int numVertices = graph.get_number_of_vertices();
+  clique.clear();
+  members.clear();
+  addCandidates.clear();
+  swapCandidates.clear();
+  std::fill(tabuUntil.begin(), tabuUntil.end(), 0);
+  std::fill(miss.begin(), miss.end(), 0);
+  for (int v : solution) {
+    clique.insert(v);
+    members.set(v);
+  }
+  for (int v : solution) {
+    graph.for_each_non_neighbour(v, [this](int u) { miss[u]++; });
+  }
+  for (int v = 0; v < numVertices; ++v) {
+    if (clique.contains(v))
+      continue;
+    if (miss[v] == 0)
+      addCandidates.insert(v);
+    else if (miss[v] == 1)
+      swapCandidates.insert(v);
+  }
+}
 
-    if (neighborhood.empty()) {
-      std::cout << "Sem mais vizinhos disponiveis." << std::endl;
-      break;
-    }
+// Move v between the add and swap candidate lists as its miss count changes
+void TabuSearch::changeMiss(int v, int delta) {
+  if (miss[v] == 0)
+    addCandidates.erase(v);
+  else if (miss[v] == 1)
+    swapCandidates.erase(v);
+  miss[v] += delta;
+  if (miss[v] == 0)
+    addCandidates.insert(v);
+  else if (miss[v] == 1)
+    swapCandidates.insert(v);
+}
 
-    std::vector<int> bestNeighbor = selectBestNeighbor(neighborhood);
-    int neighborFitness = computeObjectiveFunction(bestNeighbor);
+// v must be an add candidate; every non-neighbour of v is outside the clique
+void TabuSearch::addVertex(int v) {
+  addCandidates.erase(v);
+  clique.insert(v);
+  members.set(v);
+  PROFILE_COUNT(profile, Counter::AdjacencyQueries, 1);
+  graph.for_each_non_neighbour(v, [this](int u) { changeMiss(u, 1); });
+}
 
-    currentSolution = bestNeighbor;
+void TabuSearch::dropVertex(int v) {
+  clique.erase(v);
+  members.reset(v);
+  PROFILE_COUNT(profile, Counter::AdjacencyQueries, 1);
+  graph.for_each_non_neighbour(v, [this](int u) { changeMiss(u, -1); });
+  addCandidates.insert(v);
+}
 
-    if (neighborFitness > bestFitness) {
-      bestFitness = neighborFitness;
-      bestSolution = bestNeighbor;
-    }
+// A random add candidate that is not tabu, or any candidate if it would beat the best clique
+// (aspiration); -1 if there is none
+int TabuSearch::selectAdd(long long iteration) {
+  int size = addCandidates.size();
+  if (size == 0)
+    return -1;
+  int start = rng() % size;
+  bool aspiration = clique.size() + 1 > bestClique;
+  for (int i = 0; i < size; ++i) {
+    int v = addCandidates[(start + i) % size];
+    if (aspiration || tabuUntil[v] <= iteration)
+      return v;
+  }
+  return -1;
+}
 
-    tabuList.push_back(currentSolution);
-    if ((int) tabuList.size() > maxTabuSize) {
-      tabuList.pop_front();
+// The single clique member a swap candidate v is not adjacent to
+int TabuSearch::missingMember(int v) {
+  PROFILE_COUNT(profile, Counter::AdjacencyQueries, graph.is_dense() ? 1 : (long long)clique.size());
+  if (graph.is_dense()) {
+    const word_t *row = graph.get_row(v);
+    for (int w = 0; w < members.get_number_of_words(); ++w) {
+      word_t bits = members.data()[w] & ~row[w];
+      if (bits)
+        return w * WORD_BITS + __builtin_ctzll(bits);
     }
-
-    currentIteration++;
+    return -1;
+  }
+  for (int u : clique) {
+    if (!graph.is_edge(u, v))
+      return u;
   }
-  bestClique = bestFitness;
-  std::cout << "Melhor clique encontrada: " << bestFitness << std::endl;
+  return -1;
 }
 
-std::vector<std::vector<int>>
-TabuSearch::generateNeighborhood(const std::vector<int> &solution,
-                                 const std::deque<std::vector<int>> &tabuList) {
-  std::vector<std::vector<int>> neighbors;
-  int numVertices = graph.get_number_of_vertices();
-
-  for (int i = 0; i < numVertices; ++i) {
-    if(std::find(solution.begin(), solution.end(), i) == solution.end()) {
-      std::vector<int> newSolution = solution;
-      newSolution.push_back(i);
+// A random swap candidate that is not tabu and whose partner in the clique is not tabu
+// either; returns the entering vertex and sets leaving, or -1
+int TabuSearch::selectSwap(long long iteration, int &leaving) {
+  int size = swapCandidates.size();
+  if (size == 0)
+    return -1;
+  int start = rng() % size;
+  for (int i = 0; i < size; ++i) {
+    int v = swapCandidates[(start + i) % size];
+    if (tabuUntil[v] > iteration)
+      continue;
+    leaving = missingMember(v);
+    if (tabuUntil[leaving] <= iteration)
+      return v;
+  }
+  return -1;
+}
 
-      if ((std::find(tabuList.begin(), tabuList.end(), newSolution) == tabuList.end() ||
-           computeObjectiveFunction(newSolution) >
-               computeObjectiveFunction(bestSolution)) &&
-          isClique(newSolution)) {
-        neighbors.push_back(newSolution);
-      }
-    }
+// A random clique member that is not tabu; if all are, the one whose tenure ends first
+int TabuSearch::selectDrop(long long iteration) {
+  int size = clique.size();
+  if (size == 0)
+    return -1;
+  int start = rng() % size;
+  int oldest = clique[start];
+  for (int i = 0; i < size; ++i) {
+    int v = clique[(start + i) % size];
+    if (tabuUntil[v] <= iteration)
+      return v;
+    if (tabuUntil[v] < tabuUntil[oldest])
+      oldest = v;
   }
+  return oldest;
+}
 
-  for (size_t i = 0; i < solution.size(); ++i) {
-    std::vector<int> newSolution = solution;
-    newSolution.erase(newSolution.begin() + i);
+void TabuSearch::setStallPolicy(StallPolicy policy, long long iterations) {
+  stallPolicy = policy;
+  stallIterations = iterations;
+}
 
-    if (std::find(tabuList.begin(), tabuList.end(), newSolution) ==
-            tabuList.end() &&
-        isClique(newSolution)) {
-      neighbors.push_back(newSolution);
+void TabuSearch::escapeStall(long long iteration) {
+  PROFILE_PHASE(profile, Phase::Restart);
+  PROFILE_COUNT(profile, Counter::Restarts, 1);
+  if (stallPolicy == StallPolicy::Perturb) {
+    for (int k = clique.size() / 2; k > 0; --k) {
+      int v = clique[rng() % clique.size()];
+      dropVertex(v);
+      tabuUntil[v] = iteration + maxTabuSize;
     }
+  } else if (stallPolicy == StallPolicy::Restart) {
+    while (!clique.empty()) {
+      dropVertex(clique[clique.size() - 1]);
+    }
+    std::fill(tabuUntil.begin(), tabuUntil.end(), 0);
+    addVertex(rng() % graph.get_number_of_vertices());
   }
+}
 
-  return neighbors;
+void TabuSearch::setStoppingCriteria(const StoppingCriteria &criteria) {
+  stopping = StoppingPolicy(criteria);
 }
 
-std::vector<int> TabuSearch::selectBestNeighbor(
-    const std::vector<std::vector<int>> &neighborhood) {
-  std::vector<int> bestNeighbor = neighborhood.front();
-  int bestFitness = computeObjectiveFunction(bestNeighbor);
+const StoppingPolicy &TabuSearch::getStoppingPolicy() const { return stopping; }
 
-  for (const auto &neighbor : neighborhood) {
-    int fitness = computeObjectiveFunction(neighbor);
-    if (fitness > bestFitness) {
-      bestFitness = fitness;
-      bestNeighbor = neighbor;
-    }
+const SolverProfile &TabuSearch::getProfile() const { return profile; }
+
+void TabuSearch::run() {
+  stopping.start();
+  profile.reset();
+  {
+    PROFILE_PHASE(profile, Phase::Initialisation);
+    initialize(currentSolution);
   }
+  long long currentIteration = 0;
+  long long lastImprovement = 0;
+  bestClique = clique.size();
+  bestSolution.assign(clique.begin(), clique.end());
+  stopping.improve(bestClique);
+
+  PROFILE_PHASE(profile, Phase::Moves);
+  while (!stopping.should_stop()) {
+    if(currentIteration % 100000 == 0)
+      std::cout << "Iteration: " << currentIteration << std::endl;
 
-  return bestNeighbor;
-}
+    // Prefer improving adds, then plateau swaps, and drop only when neither is allowed
+    int leaving = -1;
+    PROFILE_COUNT(profile, Counter::CandidatesExamined, addCandidates.size() + swapCandidates.size());
+    int v = selectAdd(currentIteration);
+    if (v >= 0) {
+      PROFILE_COUNT(profile, Counter::AddMoves, 1);
+      addVertex(v);
+      tabuUntil[v] = currentIteration + maxTabuSize * 6 / 10;
+    } else if ((v = selectSwap(currentIteration, leaving)) >= 0) {
+      PROFILE_COUNT(profile, Counter::SwapMoves, 1);
+      dropVertex(leaving);
+      addVertex(v);
+      tabuUntil[leaving] = currentIteration + maxTabuSize + rng() % (swapCandidates.size() + 1);
+      tabuUntil[v] = currentIteration + maxTabuSize * 6 / 10;
+    } else {
+      v = selectDrop(currentIteration);
+      if (v < 0) {
+        std::cout << "Sem mais vizinhos disponiveis." << std::endl;
+        break;
+      }
+      PROFILE_COUNT(profile, Counter::DropMoves, 1);
+      dropVertex(v);
+      tabuUntil[v] = currentIteration + maxTabuSize;
+    }
 
-int TabuSearch::computeObjectiveFunction(const std::vector<int> &solution) {
-  assert(isClique(solution) && "Solution is not a clique.");
-  return solution.size();
+    if (clique.size() > bestClique) {
+      bestClique = clique.size();
+      bestSolution.assign(clique.begin(), clique.end());
+      lastImprovement = currentIteration;
+      stopping.improve(bestClique);
+    } else if (stallPolicy != StallPolicy::None && currentIteration - lastImprovement >= stallIterations) {
+      escapeStall(currentIteration);
+      lastImprovement = currentIteration;
+    }
+
+    currentIteration++;
+  }
+  currentSolution.assign(clique.begin(), clique.end());
+  std::cout << "Melhor clique encontrada: " << bestClique << std::endl;
 }
 
 bool TabuSearch::isClique(const std::vector<int> &solution) {
-  for (size_t i = 0; i < solution.size(); ++i) {
-    for (size_t j = i + 1; j < solution.size(); ++j) {
-      if (!graph.is_edge(solution[i], solution[j])) {
-        return false;
-      }
-    }
+  VertexSet members(graph.get_number_of_vertices());
+  for (int v : solution) {
+    members.set(v);
   }
-  return true;
+  return graph.is_clique(members);
 }
 
 std::vector<int> TabuSearch::getBestSolution() const { return bestSolution; }
@@ -2,10 +2,25 @@
 #define TABU_SEARCH_H
 
 #include "../graph/graph.h"
+#include "../graph/vertex_list.h"
+#include "../common/random.h"
+#include "../common/stopping.h"
+#include "../common/profile.h"
 #include <vector>
-#include <deque>
+#include <random>
 #include <cassert>
 
+// What to do when the best clique has not improved for stallIterations iterations
+enum class StallPolicy {
+    None,    // keep searching from where we are
+    Perturb, // drop a random half of the current clique
+    Restart  // start over from a single random vertex
+};
+
+// Multi-neighbourhood tabu search over cliques with add, (1,1)-swap and drop moves.
+// For every vertex outside the clique it keeps miss[v], the number of clique members
+// v is not adjacent to, so the vertices that can be added (miss 0) and swapped in
+// (miss 1) are always at hand and every move costs one pass over a non-neighbourhood.
 class TabuSearch {
 private:
     const Graph &graph;
@@ -13,15 +28,42 @@ private:
     std::vector<int> bestSolution;
 	int bestClique;
     int maxTabuSize;
-    int maxIterations;
 
-    std::vector<std::vector<int>> generateNeighborhood(const std::vector<int>& solution, const std::deque<std::vector<int>>& tabuList);
-    std::vector<int> selectBestNeighbor(const std::vector<std::vector<int>>& neighborhood);
-    int computeObjectiveFunction(const std::vector<int>& solution);
+    CounterRng rng;
+    StallPolicy stallPolicy;
+    long long stallIterations;
+    VertexList clique;
+    VertexSet members; // Same vertices as clique, packed
+    VertexList addCandidates;  // v outside the clique with miss[v] == 0
+    VertexList swapCandidates; // v outside the clique with miss[v] == 1
+    std::vector<int> miss;
+    // Vertex v may not be moved again before iteration tabuUntil[v]
+    std::vector<long long> tabuUntil;
+    StoppingPolicy stopping; // Counts moves; defaults to maxIterations of them
+    SolverProfile profile;
+
+    void initialize(const std::vector<int>& solution);
+    void changeMiss(int v, int delta);
+    void addVertex(int v);
+    void dropVertex(int v);
+    int missingMember(int v);
+    int selectAdd(long long iteration);
+    int selectSwap(long long iteration, int &leaving);
+    int selectDrop(long long iteration);
+    void escapeStall(long long iteration);
     bool isClique(const std::vector<int>& solution);
 
 public:
-    TabuSearch(const Graph &graph, const std::vector<int>& initialSolution, int maxTabuSize, int maxIterations);
+    // maxTabuSize is the base tenure: how many iterations a moved vertex stays tabu.
+    // Vertices swapped out stay tabu longer the larger the swap neighbourhood is.
+    TabuSearch(const Graph &graph, const std::vector<int>& initialSolution, int maxTabuSize, int maxIterations,
+               std::uint64_t seed = std::random_device{}());
+    void setStallPolicy(StallPolicy policy, long long iterations);
+    // Replace the default stopping criteria (just the iteration budget) for the next runs
+    void setStoppingCriteria(const StoppingCriteria &criteria);
+    const StoppingPolicy &getStoppingPolicy() const;
+    // Counters and phase times of the last run; all zero unless built with CLIQUE_PROFILE
+    const SolverProfile &getProfile() const;
     void run();
     std::vector<int> getBestSolution() const;
 	int getBestClique() const;
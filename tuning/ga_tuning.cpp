@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include "ga_tuning.h"
+#include "../ga/ga.h"
+#include "../batch/batch.h"
+#include "../common/random.h"
+
+std::string GaParameters::key() const
+{
+    std::ostringstream key;
+    key << crossover_probability << "," << mutation_probability << "," << population_size << "," << generations;
+    return key.str();
+}
+
+std::vector<GaParameters> GaParameterSpace::grid() const
+{
+    std::vector<GaParameters> configurations;
+    for (double pc : crossover_probabilities)
+        for (double pm : mutation_probabilities)
+            for (int pop : population_sizes)
+                for (int gens : generations)
+                    configurations.push_back(GaParameters{pc, pm, pop, gens});
+    return configurations;
+}
+
+std::vector<GaParameters> GaParameterSpace::sample(int count, std::uint64_t seed) const
+{
+    auto uniform_real = [](CounterRng &rng, const std::vector<double> &values)
+    {
+        auto [low, high] = std::minmax_element(values.begin(), values.end());
+        return std::round((*low + rng.uniform() * (*high - *low)) * 100.0) / 100.0;
+    };
+    auto uniform_int = [](CounterRng &rng, const std::vector<int> &values)
+    {
+        auto [low, high] = std::minmax_element(values.begin(), values.end());
+        return *low + (int)(rng() % (std::uint64_t)(*high - *low + 1));
+    };
+
+    std::vector<GaParameters> configurations;
+    std::set<std::string> keys;
+    if (crossover_probabilities.empty() || mutation_probabilities.empty() || population_sizes.empty() || generations.empty())
+        return configurations;
+    // Draw i uses stream i, so a larger count extends a smaller one; give up on duplicates eventually
+    for (int i = 0; (int)configurations.size() < count && i < 20 * count; ++i)
+    {
+        CounterRng rng(seed, stream_id(0, i));
+        GaParameters parameters;
+        parameters.crossover_probability = uniform_real(rng, crossover_probabilities);
+        parameters.mutation_probability = uniform_real(rng, mutation_probabilities);
+        parameters.population_size = uniform_int(rng, population_sizes);
+        parameters.generations = uniform_int(rng, generations);
+        if (keys.insert(parameters.key()).second)
+            configurations.push_back(parameters);
+    }
+    return configurations;
+}
+
+GaTuner::GaTuner(const Graph &graph, const std::string &instance, const std::string &output_file)
+    : graph(graph), instance(instance), output_file(output_file)
+{
+    read_checkpoint();
+}
+
+// Rows are "execution,graph_file_pretty,clique_size_ga,exec_time_ga,pc,pm,pop,gens,ga_version"; rows of
+// other GA versions, or written before the column existed, are ignored
+void GaTuner::read_checkpoint()
+{
+    std::ifstream in(output_file);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        // A last line without its newline was cut short by a crash
+        if (in.eof())
+            break;
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        for (std::string field; std::getline(stream, field, ',');)
+            fields.push_back(field);
+        if (fields.size() != 9 || fields[0].empty() || fields[1] != instance ||
+            fields[8] != std::to_string(GeneticAlgorithm::VERSION))
+            continue;
+        try
+        {
+            GaParameters parameters{std::stod(fields[4]), std::stod(fields[5]), std::stoi(fields[6]), std::stoi(fields[7])};
+            runs[parameters.key()][std::stoi(fields[0]) - 1] = Run{std::stoi(fields[2]), std::stod(fields[3])};
+        }
+        catch (const std::exception &)
+        {
+            // Not a result row
+        }
+    }
+}
+
+// Runs every configuration up to `repetitions` times, skipping the runs already recorded
+void GaTuner::run_rung(const std::vector<GaParameters> &configurations, int repetitions, int threads)
+{
+    BatchRunner runner(threads);
+    for (int c = 0; c < (int)configurations.size(); ++c)
+    {
+        const std::map<int, Run> &done = runs[configurations[c].key()];
+        for (int r = 0; r < repetitions; ++r)
+        {
+            if (!done.count(r))
+                runner.add_job(0, c, r, (double)configurations[c].population_size * configurations[c].generations);
+        }
+    }
+
+    bool write_header = !std::filesystem::exists(output_file) || std::filesystem::file_size(output_file) == 0;
+    // Flushed after every row (the default): the file is the checkpoint
+    CsvWriter out(output_file);
+    if (!out.is_open())
+    {
+        std::cerr << "Erro ao abrir o arquivo de output: " << output_file << std::endl;
+        return;
+    }
+    if (write_header)
+        out.write_row(",graph_file_pretty,clique_size_ga,exec_time_ga,pc,pm,pop,gens,ga_version"); // column names
+
+    runner.run([&](const BatchJob &job)
+               {
+        const GaParameters &parameters = configurations[job.configuration];
+        auto start = std::chrono::high_resolution_clock::now();
+        GeneticAlgorithm ga(graph, parameters.population_size, parameters.crossover_probability,
+                            parameters.mutation_probability, parameters.generations);
+        int clique_size = ga.run().size();
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::ostringstream row;
+        row << (job.repetition + 1) << "," << instance << "," << clique_size << "," << seconds << "," << parameters.key() << ","
+            << GeneticAlgorithm::VERSION;
+        out.write_row(row.str());
+        std::lock_guard<std::mutex> lock(runs_mutex);
+        runs[parameters.key()][job.repetition] = Run{clique_size, seconds}; });
+}
+
+// Over the first `repetitions` runs of the configuration
+TuningResult GaTuner::summary(const GaParameters &parameters, int repetitions)
+{
+    TuningResult result{parameters, 0, 0.0, 0, 0.0};
+    for (const auto &[repetition, run] : runs[parameters.key()])
+    {
+        if (repetition >= repetitions)
+            break;
+        ++result.runs;
+        result.mean_clique += run.clique_size;
+        result.best_clique = std::max(result.best_clique, run.clique_size);
+        result.mean_seconds += run.seconds;
+    }
+    if (result.runs > 0)
+    {
+        result.mean_clique /= result.runs;
+        result.mean_seconds /= result.runs;
+    }
+    return result;
+}
+
+std::vector<TuningResult> GaTuner::run(const std::vector<GaParameters> &configurations, const TuningOptions &options)
+{
+    auto better = [](const TuningResult &a, const TuningResult &b)
+    {
+        if (a.mean_clique != b.mean_clique)
+            return a.mean_clique > b.mean_clique;
+        return a.mean_seconds < b.mean_seconds;
+    };
+
+    // Configurations dropped by successive halving keep the results of their last rung
+    std::map<std::string, TuningResult> results;
+    std::vector<GaParameters> survivors = configurations;
+    int repetitions = options.first_rung > 0 ? std::min(options.first_rung, options.repetitions) : options.repetitions;
+    int eta = std::max(2, options.eta);
+    while (!survivors.empty())
+    {
+        run_rung(survivors, repetitions, options.threads);
+        std::vector<TuningResult> rung;
+        for (const GaParameters &parameters : survivors)
+        {
+            rung.push_back(summary(parameters, repetitions));
+            results[parameters.key()] = rung.back();
+        }
+        if (repetitions >= options.repetitions)
+            break;
+
+        std::stable_sort(rung.begin(), rung.end(), better);
+        rung.resize((rung.size() + eta - 1) / eta);
+        survivors.clear();
+        for (const TuningResult &result : rung)
+            survivors.push_back(result.parameters);
+        repetitions = std::min(repetitions * eta, options.repetitions);
+    }
+
+    // Configurations that survived longer come first, then by their results
+    std::vector<TuningResult> ranking;
+    for (const auto &[key, result] : results)
+        ranking.push_back(result);
+    std::stable_sort(ranking.begin(), ranking.end(), [&](const TuningResult &a, const TuningResult &b)
+                     {
+        if (a.runs != b.runs)
+            return a.runs > b.runs;
+        return better(a, b); });
+    return ranking;
+}
@@ -0,0 +1,87 @@
+#ifndef GA_TUNING_H
+#define GA_TUNING_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../graph/graph.h"
+
+struct GaParameters
+{
+    double crossover_probability;
+    double mutation_probability;
+    int population_size;
+    int generations;
+
+    // "pc,pm,pop,gens", as written in the output CSV; identifies the configuration
+    std::string key() const;
+};
+
+// Values tried for each parameter. The grid is their cartesian product; random search draws
+// every parameter uniformly between the smallest and the largest value listed.
+struct GaParameterSpace
+{
+    std::vector<double> crossover_probabilities;
+    std::vector<double> mutation_probabilities;
+    std::vector<int> population_sizes;
+    std::vector<int> generations;
+
+    std::vector<GaParameters> grid() const;
+    // `count` distinct configurations (fewer if the space is smaller), probabilities rounded
+    // to two decimals; the same seed always draws the same ones, so a rerun can resume
+    std::vector<GaParameters> sample(int count, std::uint64_t seed) const;
+};
+
+struct TuningOptions
+{
+    int repetitions = 5; // Runs of every configuration that reaches the last rung
+    // Successive halving: runs of every configuration in the first rung, 0 to run them all
+    // `repetitions` times
+    int first_rung = 0;
+    int eta = 3;     // Each rung keeps the best 1/eta of the configurations and gives them eta times the runs
+    int threads = 0; // 0: hardware concurrency
+};
+
+struct TuningResult
+{
+    GaParameters parameters;
+    int runs;
+    double mean_clique;
+    int best_clique;
+    double mean_seconds;
+};
+
+// Runs the GA on one instance for many configurations, one run per job on a BatchRunner.
+// Each finished run is appended and flushed to the output CSV right away, and that file is
+// also the checkpoint: runs it already lists for this instance and GeneticAlgorithm::VERSION are
+// read back and not repeated, so a search cut short by a crash or a timeout picks up where it stopped.
+class GaTuner
+{
+private:
+    struct Run
+    {
+        int clique_size;
+        double seconds;
+    };
+
+    const Graph &graph;
+    std::string instance;
+    std::string output_file;
+    std::mutex runs_mutex;                          // Guards runs
+    std::map<std::string, std::map<int, Run>> runs; // Configuration key -> repetition -> run
+
+    void read_checkpoint();
+    void run_rung(const std::vector<GaParameters> &configurations, int repetitions, int threads);
+    TuningResult summary(const GaParameters &parameters, int repetitions);
+
+public:
+    GaTuner(const Graph &graph, const std::string &instance, const std::string &output_file);
+
+    // Results of every configuration, best first: those that reached later rungs, then by mean
+    // clique size and mean time. With successive halving the ones dropped early have fewer runs.
+    std::vector<TuningResult> run(const std::vector<GaParameters> &configurations, const TuningOptions &options);
+};
+
+#endif // GA_TUNING_H